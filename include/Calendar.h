@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+
+/**
+   Broken-down time that follows a running clock. Moving forward by less
+   than a day carries the seconds into minutes, hours and days instead of
+   converting the whole epoch again; only a step back or a jump of a day or
+   more (a sync step, a time zone transition is just an hour) falls back to
+   a full conversion.
+
+   Times are 64-bit seconds since 1970. The full conversion is done here
+   rather than by gmtime_r(), whose time_t is 32 bits on older ESP32 cores
+   and ends in 2038.
+*/
+class Calendar {
+  public:
+    /**
+       @param time seconds since 1970, already in the time zone to show
+       @return the broken-down time, valid until the next call
+    */
+    const struct tm* at(int64_t time);
+
+    /**
+       Full conversion of seconds since 1970 (proleptic Gregorian, no leap
+       seconds), like gmtime_r().
+    */
+    static void breakDown(int64_t time, struct tm& tm);
+
+    /**
+       @return number of full conversions so far
+    */
+    unsigned long recomputes() const { return _recomputes; }
+
+  private:
+    struct tm     _tm = {};
+    int64_t       _time = 0;
+    bool          _valid = false;
+    unsigned long _recomputes = 0;
+
+    void advance(long seconds);
+};
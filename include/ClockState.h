@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include <NTPClient.h>
+#include <Preferences.h>
+
+/**
+   Clock state kept in NVS across reboots: the time of the last good sync,
+   the drift learned so far and the addresses of the NTP servers. Restoring
+   it lets the display show an estimated time as soon as it is up and lets
+   the first sync go out without DNS, with the frequency already trimmed.
+
+   The saved time is only a lower bound: the clock was off for an unknown
+   while. The first sync steps it to the right time.
+*/
+class ClockState {
+  public:
+    /**
+       Seed the client with the saved state. Call after the servers were
+       added, before the first update.
+
+       @return false if nothing usable was saved
+    */
+    bool restore(NTPClient& client);
+
+    /**
+       Save the state of a client that just synced. Unchanged addresses are
+       not rewritten, to spare the flash.
+    */
+    void save(const NTPClient& client);
+
+    /**
+       @return UTC of the last good sync in µs since 1970, 0 if none
+    */
+    uint64_t lastSyncMicros() const;
+
+  private:
+    // Bump when the layout below or the server list of the sketch changes
+    static const uint8_t VERSION = 1;
+
+    struct SavedServer {
+      uint8_t count;
+      uint8_t addresses[NTP_MAX_ADDRESSES][4];
+    };
+
+    Preferences _preferences;
+    uint64_t _lastSync = 0;
+    SavedServer _servers[NTP_MAX_SERVERS] = {};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+   Running count of events.
+*/
+class Counter {
+  public:
+    void add(uint32_t n = 1) { _value += n; }
+    uint32_t value() const { return _value; }
+
+  private:
+    uint32_t _value = 0;
+};
+
+/**
+   Distribution of non-negative values in power-of-two buckets: bucket 0
+   holds zeros, bucket b values from 2^(b-1) to 2^b - 1, the last one
+   everything above. Exact count, sum, min and max are kept next to them;
+   percentiles are read off the buckets, so they are rounded up to the top
+   of one (and never beyond max).
+*/
+class Histogram {
+  public:
+    static const uint8_t BUCKETS = 24; // The last exact one ends at 2^22 - 1, 4.19 s in µs; then the overflow
+
+    void record(uint32_t value);
+
+    uint32_t count() const { return _count; }
+    uint32_t lowest() const { return _min; }
+    uint32_t highest() const { return _max; }
+    uint32_t mean() const { return _count ? _sum / _count : 0; }
+    uint32_t bucket(uint8_t index) const { return _buckets[index]; }
+
+    /**
+       @param percent 0-100
+       @return value that many percent of the recorded ones do not exceed
+    */
+    uint32_t percentile(uint8_t percent) const;
+
+  private:
+    uint32_t _buckets[BUCKETS] = {};
+    uint32_t _count = 0;
+    uint32_t _min = 0;
+    uint32_t _max = 0;
+    uint64_t _sum = 0;
+};
+
+/**
+   Registry of the sketch's counters and histograms, handed out by name from
+   fixed tables. Recording is a few integer operations on a slot that exists
+   from startup on: no lock, no allocation, no formatting. Everything is
+   recorded and printed from the loop task, so nothing can interleave.
+
+   printLines() writes one line per metric for the serial console:
+
+     metrics uptime_ms=600000
+     ntp.syncs 12
+     ntp.rtt_us n=12 min=18210 p50=32767 p90=61877 p99=61877 max=61877 mean=36840
+
+   printJson() writes the same as one JSON object, with the buckets. The
+   host build writes it to the file given with --metrics on exit.
+*/
+class Metrics {
+  public:
+    static const uint8_t MAX_COUNTERS = 8;
+    static const uint8_t MAX_HISTOGRAMS = 12;
+
+    Metrics();
+
+    /**
+       @param name kept, not copied
+       @return the counter, or a spare that is never printed if the table is full
+    */
+    Counter& counter(const char* name);
+    Histogram& histogram(const char* name);
+
+    void printLines(Print& out) const;
+    void printJson(Print& out) const;
+
+  private:
+    Counter     _counters[MAX_COUNTERS];
+    const char* _counterNames[MAX_COUNTERS];
+    uint8_t     _counterCount = 0;
+    Histogram   _histograms[MAX_HISTOGRAMS];
+    const char* _histogramNames[MAX_HISTOGRAMS];
+    uint8_t     _histogramCount = 0;
+    Counter     _spareCounter;
+    Histogram   _spareHistogram;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+   Deadline scheduler for the sketch. Each task is a callback with a due time
+   in millis(); loop() runs whatever is due and then sleeps until the earliest
+   remaining deadline instead of polling at a fixed rate. Tasks re-arm
+   themselves from their callback. Deadlines are compared in 32-bit millis()
+   arithmetic, so they survive the 49.7-day wrap.
+*/
+class Scheduler {
+  public:
+    typedef void (*Callback)();
+
+    static const uint8_t MAX_TASKS = 10;
+    // Upper bound on a single sleep so nothing starves if all tasks are idle
+    static const unsigned long MAX_SLEEP = 1000;
+
+    /**
+       Register a task. It does not run until armed with at() or in().
+
+       @return task id, or -1 if the table is full
+    */
+    int8_t add(Callback callback);
+
+    void at(int8_t task, uint32_t dueMillis);
+    void in(int8_t task, unsigned long delayMillis);
+    void cancel(int8_t task);
+
+    /**
+       Run every armed task whose deadline has passed. Each is disarmed before
+       its callback runs.
+    */
+    void runDue();
+
+    /**
+       @return ms until the earliest armed deadline, 0 if one is already due
+    */
+    unsigned long millisToNext() const;
+
+    /**
+       Sleep until the earliest armed deadline.
+    */
+    void sleepUntilNext() const;
+
+  private:
+    struct Task {
+      Callback      callback;
+      uint32_t      due;
+      bool          armed;
+    };
+
+    Task    _tasks[MAX_TASKS];
+    uint8_t _count = 0;
+};
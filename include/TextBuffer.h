@@ -0,0 +1,114 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+   Fixed-capacity, stack-allocated text builder for the display widgets.
+   Appends never touch the heap; anything past the capacity is dropped and
+   the buffer stays NUL-terminated. Numbers are formatted from a two-digit
+   lookup table, two decimal digits per step.
+*/
+template <uint8_t N>
+class TextBuffer {
+  public:
+    TextBuffer() { clear(); }
+
+    void clear() {
+      _length = 0;
+      _buf[0] = '\0';
+    }
+
+    const char* c_str() const { return _buf; }
+    uint8_t length() const { return _length; }
+
+    TextBuffer& append(char c) {
+      if (_length < N - 1) {
+        _buf[_length++] = c;
+        _buf[_length] = '\0';
+      }
+      return *this;
+    }
+
+    TextBuffer& append(const char* str) {
+      while (*str && _length < N - 1) {
+        _buf[_length++] = *str++;
+      }
+      _buf[_length] = '\0';
+      return *this;
+    }
+
+    /**
+       Append 0-99 as exactly two digits, zero padded.
+    */
+    TextBuffer& appendTwoDigits(uint8_t value) {
+      const char* pair = &DIGIT_PAIRS[2 * (value % 100)];
+      return append(pair[0]).append(pair[1]);
+    }
+
+    TextBuffer& appendUnsigned(unsigned long value) {
+      char digits[20];
+      uint8_t count = 0;
+      while (value >= 100) {
+        const char* pair = &DIGIT_PAIRS[2 * (value % 100)];
+        digits[count++] = pair[1];
+        digits[count++] = pair[0];
+        value /= 100;
+      }
+      if (value >= 10) {
+        digits[count++] = DIGIT_PAIRS[2 * value + 1];
+        digits[count++] = DIGIT_PAIRS[2 * value];
+      } else {
+        digits[count++] = '0' + value;
+      }
+      while (count) {
+        append(digits[--count]);
+      }
+      return *this;
+    }
+
+    /**
+       Append value rounded to the given number of decimals (at most 4),
+       like String(value, decimals).
+    */
+    TextBuffer& appendFixed(double value, uint8_t decimals) {
+      static const unsigned long SCALE[] = {1, 10, 100, 1000, 10000};
+      if (decimals > 4) {
+        decimals = 4;
+      }
+      if (value < 0) {
+        append('-');
+        value = -value;
+      }
+      unsigned long scaled = (unsigned long)(value * SCALE[decimals] + 0.5);
+      appendUnsigned(scaled / SCALE[decimals]);
+      if (decimals) {
+        append('.');
+        unsigned long fraction = scaled % SCALE[decimals];
+        for (unsigned long place = SCALE[decimals] / 10; place; place /= 10) {
+          append('0' + (fraction / place) % 10);
+        }
+      }
+      return *this;
+    }
+
+    bool operator==(const TextBuffer& other) const {
+      return _length == other._length && memcmp(_buf, other._buf, _length) == 0;
+    }
+    bool operator!=(const TextBuffer& other) const { return !(*this == other); }
+
+  private:
+    static constexpr char DIGIT_PAIRS[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+
+    char    _buf[N];
+    uint8_t _length;
+};
+
+template <uint8_t N>
+constexpr char TextBuffer<N>::DIGIT_PAIRS[];
+
+// One display line: 16 glyphs fit across the 96 px panel, with headroom for
+// lines that run off the edge.
+typedef TextBuffer<24> LineBuffer;
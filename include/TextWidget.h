@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Adafruit_SPITFT.h>
+#include "Metrics.h"
+#include "TextBuffer.h"
+
+/**
+   One line of text on the panel, drawn in the classic 6x8 GFX font.
+
+   The widget remembers which character sits in each cell on the glass and
+   only pushes cells whose character changed, each as a single opaque
+   6x8 address-window blit. Nothing is erased by overdrawing in black.
+*/
+class TextWidget {
+  public:
+    static const uint8_t CELL_WIDTH = 6;
+    static const uint8_t CELL_HEIGHT = 8;
+
+    TextWidget(Adafruit_SPITFT& display, int16_t x, int16_t y, uint16_t color, uint16_t background = 0x0000);
+
+    /**
+       Set the text to show. Nothing is sent to the display until draw().
+    */
+    void setText(const char* text);
+    const char* text() const { return _text.c_str(); }
+
+    /**
+       Bring the glass in line with the current text, blitting only the
+       cells that differ.
+    */
+    void draw();
+
+    /**
+       Blank the widget's cells on the glass but keep its text for later.
+    */
+    void hide();
+
+    /**
+       The display was wiped behind our back (e.g. fillScreen), so every cell
+       is blank now.
+    */
+    void forget();
+
+    /**
+       Record how long each draw() or hide() that blitted anything took, in
+       µs, into renderMicros (nullptr for nowhere).
+    */
+    void setRenderTimes(Histogram* renderMicros) { _renderMicros = renderMicros; }
+
+    /**
+       @return cells blitted by all widgets so far
+    */
+    static uint32_t cellsBlitted() { return _cellsBlitted; }
+
+  private:
+    static const uint8_t MAX_CELLS = 24;
+
+    Adafruit_SPITFT& _display;
+    int16_t          _x;
+    int16_t          _y;
+    uint16_t         _color;
+    uint16_t         _background;
+
+    LineBuffer       _text;
+    char             _cells[MAX_CELLS]; // What is on the glass, ' ' = blank
+    Histogram*       _renderMicros = nullptr;
+
+    static uint32_t  _cellsBlitted;
+
+    void sync(const char* text);
+    void blitCell(uint8_t index, char c);
+};
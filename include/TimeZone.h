@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+   Local time from UTC by a POSIX TZ rule, the format of the TZ variable
+   and of the last line of a zoneinfo file, e.g.
+   "EET-2EEST,M3.5.0/3,M10.5.0/4". The offset in force is cached together
+   with the UTC span it holds for, so a conversion is an addition until the
+   next transition; only then are the transitions worked out again.
+
+   Instants are 64-bit seconds since 1970 whatever the width of time_t,
+   which is 32 bits on older ESP32 cores and would end in 2038.
+*/
+class TimeZone {
+  public:
+    /**
+       Switch to a rule. Without a DST rule a zone with DST follows the US
+       one, as POSIX prescribes.
+
+       @return false if the rule is malformed; the zone is left as it was
+    */
+    bool set(const char* rule);
+
+    /**
+       @return offset of local time from UTC at utc, in seconds east
+    */
+    long offsetAt(int64_t utc);
+
+    int64_t toLocal(int64_t utc) { return utc + offsetAt(utc); }
+
+    /**
+       @return whether daylight saving time is in force at utc
+    */
+    bool isDstAt(int64_t utc);
+
+    /**
+       @return the UTC instant the offset of the last conversion ends, if
+       the zone has DST
+    */
+    int64_t nextTransition() const { return _spanEnd; }
+
+  private:
+    enum RuleKind : uint8_t {
+      JULIAN,     // Jn: day 1-365 of the year, February 29 never counted
+      ZERO_BASED, // n: day 0-365 of the year, February 29 counted
+      MONTH_WEEK  // Mm.w.d: weekday d of week w (5 = last) of month m
+    };
+
+    struct Rule {
+      RuleKind kind;
+      uint8_t  month;
+      uint8_t  week;
+      uint8_t  weekday;
+      uint16_t day;
+      long     time; // Local time of day of the change, may be negative or past 24 h
+    };
+
+    long    _stdOffset = 0; // In s east of UTC
+    long    _dstOffset = 0;
+    bool    _hasDst = false;
+    Rule    _start = {};
+    Rule    _end = {};
+
+    // The cached span [_spanStart, _spanEnd), empty to begin with
+    int64_t _spanStart = 1;
+    int64_t _spanEnd = 0;
+    bool    _spanDst = false;
+
+    void findSpan(int64_t utc);
+    static int64_t transition(int year, const Rule& rule, long offsetBefore);
+
+    static const char* parseName(const char* p);
+    static const char* parseTime(const char* p, long& seconds, long maxHours);
+    static const char* parseRule(const char* p, Rule& rule);
+};
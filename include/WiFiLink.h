@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+/**
+   Wi-Fi station connection as a state machine the scheduler drives, so
+   nothing waits on the access point. An attempt that does not associate
+   within CONNECT_TIMEOUT is dropped and retried after a backoff that
+   doubles from MIN_BACKOFF up to MAX_BACKOFF, with up to a quarter of
+   random jitter so clocks that lost the same access point do not retry in
+   step. A lost connection is retried at once, then backs off the same way.
+*/
+class WiFiLink {
+  public:
+    enum State : uint8_t {
+      IDLE,        // Not started, or backing off before the next attempt
+      CONNECTING,  // WiFi.begin() issued, waiting to associate
+      CONNECTED
+    };
+
+    static const unsigned long CONNECT_TIMEOUT = 15000;
+    static const unsigned long MIN_BACKOFF = 1000;
+    static const unsigned long MAX_BACKOFF = 60000;
+    // Status poll period while connecting, and link check once connected
+    static const unsigned long CONNECT_POLL = 100;
+    static const unsigned long LINK_POLL = 1000;
+
+    WiFiLink(const char* ssid, const char* password);
+
+    /**
+       Advance the state machine.
+
+       @return ms until it wants to run again
+    */
+    unsigned long run();
+
+    State state() const { return _state; }
+    bool isConnected() const { return _state == CONNECTED; }
+
+    /**
+       @return failed attempts since the last successful connection
+    */
+    uint16_t failedAttempts() const { return _failures; }
+
+  private:
+    const char*   _ssid;
+    const char*   _password;
+    State         _state = IDLE;
+    uint32_t      _attemptStarted = 0;
+    unsigned long _backoff = MIN_BACKOFF;
+    uint16_t      _failures = 0;
+
+    unsigned long retryLater();
+};
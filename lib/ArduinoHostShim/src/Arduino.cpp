@@ -0,0 +1,87 @@
+/*
+  Arduino.cpp - core timing, pin and random functions on top of HostSim.
+*/
+#include <stdio.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "HostSim.h"
+#include "esp_timer.h"
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() { fflush(stdout); }
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+unsigned long millis() {
+  return (uint32_t)(sim::deviceMicros() / 1000);
+}
+
+unsigned long micros() {
+  return (uint32_t)sim::deviceMicros();
+}
+
+int64_t esp_timer_get_time() {
+  return (int64_t)sim::deviceMicros();
+}
+
+void delay(unsigned long ms) {
+  sim::advance(sim::deviceToElapsedMicros((uint64_t)ms * 1000)); // measured on the drifting crystal
+}
+
+void delayMicroseconds(unsigned int us) {
+  sim::advance(sim::deviceToElapsedMicros(us));
+}
+
+void yield() {
+  sim::advance(0);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  sim::setPin(pin, val ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin) {
+  return sim::pinState(pin);
+}
+
+uint16_t analogRead(uint8_t pin) {
+  (void)pin;
+  return (uint16_t)(sim::elapsedMicros() ^ getpid()) & 0x0fff;
+}
+
+long random(long howbig) {
+  if (howbig <= 0) {
+    return 0;
+  }
+  return ::random() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) {
+    return howsmall;
+  }
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) {
+    srandom(seed);
+  }
+}
@@ -0,0 +1,87 @@
+/*
+  Arduino.h - host (Linux) stand-in for the Arduino/ESP32 core.
+  Only what the sketch and its libraries actually use is provided.
+  Time, pins and the network are routed through the simulator in HostSim.h.
+*/
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+
+#include "pgmspace.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+enum BitOrder { LSBFIRST = 0, MSBFIRST = 1 };
+
+#ifndef PI
+#define PI         3.1415926535897932384626433832795
+#endif
+#define HALF_PI    1.5707963267948966192313216916398
+#define TWO_PI     6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define lowByte(w)  ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+#define bitRead(value, bit)  (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit)   ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+
+#define interrupts()
+#define noInterrupts()
+
+using std::min;
+using std::max;
+
+inline uint16_t word(uint8_t h, uint8_t l) { return (h << 8) | l; }
+
+template <typename T> inline T constrain(T x, T lo, T hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+template <typename T> inline T sq(T x) { return x * x; }
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+// millis()/micros() wrap at 32 bits exactly like the ESP32 core does.
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+#include "HardwareSerial.h"
+
+void setup();
+void loop();
+
+#endif
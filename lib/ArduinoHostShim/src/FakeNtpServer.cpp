@@ -0,0 +1,169 @@
+/*
+  FakeNtpServer.cpp - SNTP (RFC 4330) server mode over a loopback socket.
+*/
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "FakeNtpServer.h"
+
+static const uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+
+static void putTimestamp(uint8_t *p, uint64_t unixMicros) {
+  uint64_t seconds = unixMicros / 1000000 + NTP_UNIX_OFFSET;
+  uint64_t fraction = ((unixMicros % 1000000) << 32) / 1000000;
+  for (int i = 0; i < 4; i++) {
+    p[i] = seconds >> (24 - 8 * i);
+    p[4 + i] = fraction >> (24 - 8 * i);
+  }
+}
+
+FakeNtpServer::FakeNtpServer() {}
+
+FakeNtpServer::~FakeNtpServer() { end(); }
+
+uint16_t FakeNtpServer::begin() {
+  _fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (_fd < 0) {
+    return 0;
+  }
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (bind(_fd, (struct sockaddr *)&addr, len) != 0 || getsockname(_fd, (struct sockaddr *)&addr, &len) != 0) {
+    end();
+    return 0;
+  }
+  _port = ntohs(addr.sin_port);
+  sim::addService(this);
+  return _port;
+}
+
+void FakeNtpServer::end() {
+  if (_fd >= 0) {
+    sim::removeService(this);
+    close(_fd);
+    _fd = -1;
+  }
+  _pending.clear();
+}
+
+uint64_t FakeNtpServer::serverMicros(uint64_t elapsed) const {
+  return sim::utcMicrosAt(elapsed) + _offset;
+}
+
+uint64_t FakeNtpServer::nextRandom() {
+  // xorshift64*: cheap and the same sequence on every run
+  _random ^= _random >> 12;
+  _random ^= _random << 25;
+  _random ^= _random >> 27;
+  return _random * 0x2545F4914F6CDD1DULL;
+}
+
+bool FakeNtpServer::chance(double percent) {
+  return percent > 0 && (nextRandom() >> 11) * 0x1.0p-53 * 100 < percent;
+}
+
+void FakeNtpServer::mangle(Reply &reply) {
+  uint8_t *p = reply.packet;
+  _mangled++;
+  switch (nextRandom() % 8) {
+  case 0: // line noise
+    for (int flips = 1 + nextRandom() % 4; flips > 0; flips--) {
+      uint64_t bit = nextRandom() % (sizeof(reply.packet) * 8);
+      p[bit / 8] ^= 1 << (bit % 8);
+    }
+    break;
+  case 1:
+    p[0] = (p[0] & ~0x07) | (nextRandom() % 2 ? 3 : 5);
+    break;
+  case 2:
+    p[0] |= 0xC0;
+    break;
+  case 3:
+    p[1] = 0;
+    memcpy(p + 12, "RATE", 4);
+    break;
+  case 4:
+    reply.length = nextRandom() % sizeof(reply.packet);
+    break;
+  case 5: // answers the previous request instead
+    memcpy(p + 24, _lastOriginate, 8);
+    break;
+  case 6:
+    memset(p + 40, 0, 8);
+    break;
+  default:
+    enqueue(reply);
+    break;
+  }
+}
+
+void FakeNtpServer::enqueue(const Reply &reply) {
+  std::deque<Reply>::iterator at = _pending.end();
+  while (at != _pending.begin() && (at - 1)->sendAt > reply.sendAt) {
+    --at;
+  }
+  _pending.insert(at, reply);
+}
+
+void FakeNtpServer::poll() {
+  if (_fd < 0) {
+    return;
+  }
+
+  uint8_t request[68];
+  struct sockaddr_in from;
+  socklen_t fromLen = sizeof(from);
+  ssize_t len;
+  while ((len = recvfrom(_fd, request, sizeof(request), 0, (struct sockaddr *)&from, &fromLen)) > 0) {
+    fromLen = sizeof(from);
+    if (len < 48 || (request[0] & 0x07) != 3) {
+      continue;
+    }
+    _requests++;
+    if (chance(_lossPercent)) {
+      _dropped++;
+      continue;
+    }
+
+    uint64_t received = sim::elapsedMicros() + _uplink;
+    Reply reply;
+    reply.sendAt = received + _downlink + (_jitter ? nextRandom() % (_jitter + 1) : 0);
+    reply.to = from;
+    uint8_t *p = reply.packet;
+    memset(p, 0, sizeof(reply.packet));
+    p[0] = sim::leapIndicatorAt(received) << 6 | (request[0] & 0x38) | 4; // LI, client's version, mode 4
+    p[1] = _stratum;
+    p[2] = request[2];                          // poll
+    p[3] = 0xEC;                                // precision 2^-20 s
+    p[7] = 0x10;                                // root delay ~0.25 ms
+    p[11] = 0x10;                               // root dispersion ~0.25 ms
+    memcpy(p + 12, "SIM", 3);                   // reference ID
+    putTimestamp(p + 16, serverMicros(received) - 16000000);
+    memcpy(p + 24, request + 40, 8);            // originate = client transmit
+    putTimestamp(p + 32, serverMicros(received));
+    putTimestamp(p + 40, serverMicros(received));
+    reply.length = sizeof(reply.packet);
+    if (chance(_fuzzPercent)) {
+      mangle(reply);
+    }
+    memcpy(_lastOriginate, request + 40, 8);
+    enqueue(reply);
+  }
+
+  uint64_t now = sim::elapsedMicros();
+  while (!_pending.empty() && _pending.front().sendAt <= now) {
+    const Reply &reply = _pending.front();
+    sendto(_fd, reply.packet, reply.length, 0, (const struct sockaddr *)&reply.to, sizeof(reply.to));
+    _pending.pop_front();
+  }
+}
+
+uint64_t FakeNtpServer::nextEvent() const {
+  return _pending.empty() ? UINT64_MAX : _pending.front().sendAt;
+}
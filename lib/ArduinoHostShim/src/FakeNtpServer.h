@@ -0,0 +1,105 @@
+/*
+  FakeNtpServer.h - in-process SNTP responder on 127.0.0.1.
+
+  Answers client requests from sim::utcMicros() (plus a configurable
+  offset), announcing sim::setLeapSecond() in the leap indicator, and
+  holds each reply back for the configured one-way delays, measured on
+  the simulated clock. Requests can be dropped and replies
+  jittered to exercise the client's timeout and retry paths, and
+  mangled to exercise its validation; the random
+  source is seeded so runs stay reproducible.
+*/
+#ifndef FakeNtpServer_h
+#define FakeNtpServer_h
+
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include <deque>
+
+#include "HostSim.h"
+
+class FakeNtpServer : public sim::Service {
+public:
+  FakeNtpServer();
+  ~FakeNtpServer();
+
+  /**
+   * Bind to an ephemeral loopback port and start answering from sim::pump().
+   *
+   * @return the bound port, 0 on failure
+   */
+  uint16_t begin();
+  void end();
+
+  uint16_t port() const { return _port; }
+
+  void setOffsetMicros(int64_t offset) { _offset = offset; }
+  void setDelayMicros(uint64_t uplink, uint64_t downlink) {
+    _uplink = uplink;
+    _downlink = downlink;
+  }
+  void setStratum(uint8_t stratum) { _stratum = stratum; }
+
+  /**
+   * Percentage of requests silently dropped (0-100).
+   */
+  void setLossPercent(double percent) { _lossPercent = percent; }
+
+  /**
+   * Extra downlink delay, uniform in [0, jitter] µs per reply; replies may
+   * overtake each other.
+   */
+  void setJitterMicros(uint64_t jitter) { _jitter = jitter; }
+
+  /**
+   * Percentage of replies mangled (0-100): bit flips, wrong mode, leap
+   * indicator 3, kiss-o'-death RATE, truncation, a stale originate
+   * timestamp, a missing transmit timestamp or a duplicate.
+   */
+  void setFuzzPercent(double percent) { _fuzzPercent = percent; }
+
+  /**
+   * Seed of the loss/jitter sequence, so several servers do not move in step.
+   */
+  void setSeed(uint64_t seed) { _random = seed | 1; }
+
+  uint64_t requests() const { return _requests; }
+  uint64_t dropped() const { return _dropped; }
+  uint64_t mangled() const { return _mangled; }
+
+  void poll() override;
+  uint64_t nextEvent() const override;
+
+private:
+  struct Reply {
+    uint64_t sendAt;
+    struct sockaddr_in to;
+    uint8_t packet[48];
+    size_t length;
+  };
+
+  int _fd = -1;
+  uint16_t _port = 0;
+  int64_t _offset = 0;
+  uint64_t _uplink = 0;
+  uint64_t _downlink = 0;
+  uint8_t _stratum = 1;
+  double _lossPercent = 0;
+  uint64_t _jitter = 0;
+  uint64_t _requests = 0;
+  uint64_t _dropped = 0;
+  double _fuzzPercent = 0;
+  uint64_t _mangled = 0;
+  uint8_t _lastOriginate[8] = {};
+  uint64_t _random = 0x9E3779B97F4A7C15ULL;
+  std::deque<Reply> _pending; // ordered by sendAt
+
+  uint64_t serverMicros(uint64_t elapsed) const;
+  uint64_t nextRandom();
+  bool chance(double percent);
+  void mangle(Reply &reply);
+  void enqueue(const Reply &reply);
+};
+
+#endif
@@ -0,0 +1,28 @@
+/*
+  HardwareSerial.h - Serial is stdout on the host.
+*/
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include "Stream.h"
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override;
+
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,35 @@
+/*
+  HostAlloc.cpp - global operator new/delete that count heap allocations,
+  so the host build can report how much the sketch allocates per frame.
+*/
+#include <stdlib.h>
+
+#include <new>
+
+#include "HostSim.h"
+
+static uint64_t allocations = 0;
+static int uncounted = 0; // Nesting depth of UncountedAllocations scopes
+
+uint64_t sim::heapAllocations() { return allocations; }
+
+sim::UncountedAllocations::UncountedAllocations() { uncounted++; }
+sim::UncountedAllocations::~UncountedAllocations() { uncounted--; }
+
+static void *allocate(size_t size) {
+  if (!uncounted) {
+    allocations++;
+  }
+  void *p = malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
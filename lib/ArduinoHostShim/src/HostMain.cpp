@@ -0,0 +1,255 @@
+/*
+  HostMain.cpp - entry point of the native build: wires up the simulated
+  board, runs setup()/loop() like the ESP32 core and reports on exit.
+  Left out of `pio test` builds, whose test programs bring their own main().
+*/
+#ifndef PIO_UNIT_TESTING
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Arduino.h"
+#include "FakeNtpServer.h"
+#include "HostSim.h"
+#include "NtpLoadGenerator.h"
+#include "Print.h"
+#include "Ssd1331Sim.h"
+
+// Same wiring as the pin definitions in src/main.cpp.
+static Ssd1331Sim panel(/* cs */ 17, /* dc */ 16, /* mosi */ 23, /* sck */ 18, /* rst */ 4);
+static FakeNtpServer ntpServer;
+// Extra servers added with --ntp-server, one route each; the sketch can add up to three.
+static FakeNtpServer extraServers[3];
+static const char *extraNames[3];
+static int extraCount = 0;
+static NtpLoadGenerator ntpLoad;
+static double ntpLoadRate = 0;
+
+static const char *dumpPath = nullptr;
+static const char *metricsPath = nullptr;
+static bool dumpAscii = false;
+static uint64_t loops = 0;
+static uint64_t setupAllocations = 0;
+
+class FilePrint : public Print {
+public:
+  explicit FilePrint(FILE *file) : _file(file) {}
+  size_t write(uint8_t c) override { return fputc(c, _file) == EOF ? 0 : 1; }
+  size_t write(const uint8_t *buffer, size_t size) override { return fwrite(buffer, 1, size, _file); }
+
+private:
+  FILE *_file;
+};
+
+static void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --seconds N        stop after N simulated seconds\n"
+          "  --virtual-time     delay() advances simulated time instead of sleeping\n"
+          "  --epoch T          simulated UTC at start, unix seconds (fractions allowed)\n"
+          "  --drift-ppm P      crystal frequency error seen by millis()/micros()\n"
+          "  --uptime S         the device has been up S seconds at start (try 4294900)\n"
+          "  --leap-insert T    insert a leap second before the UTC midnight T (unix seconds)\n"
+          "  --leap-delete T    delete the last second before the UTC midnight T\n"
+          "  --wifi-delay MS    Wi-Fi association time, negative never connects\n"
+          "  --wifi-up-at S     the access point comes up S simulated seconds in\n"
+          "  --ntp-offset MS    fake NTP server clock offset\n"
+          "  --ntp-delay MS     fake NTP one-way network delay\n"
+          "  --ntp-jitter MS    extra random delay on each fake NTP reply\n"
+          "  --ntp-loss PCT     fake NTP drops this percentage of requests\n"
+          "  --ntp-fuzz PCT     fake NTP mangles this percentage of replies\n"
+          "  --ntp-server HOST[:OFFSET_MS[:DELAY_MS]]\n"
+          "                     answer for HOST from a separate fake server with its own\n"
+          "                     offset and delay (repeatable; jitter and loss are shared)\n"
+          "  --dns-delay MS     time each stub DNS lookup blocks\n"
+          "  --dns-addresses N  stand-in addresses per name, returned round-robin\n"
+          "  --dns-dead K       address K (from 0) of every name never answers\n"
+          "  --ntp-load RATE    send RATE requests/s to the sketch's own NTP server\n"
+          "  --nvs FILE         keep Preferences (NVS) in FILE across runs\n"
+          "  --real-ntp         talk to pool.ntp.org instead of the fake server\n"
+          "  --dump FILE        write the final panel contents as PPM\n"
+          "  --metrics FILE     write the sketch's metrics registry as JSON on exit\n"
+          "  --ascii            print the final panel contents to stdout\n",
+          argv0);
+}
+
+static void report() {
+  fflush(stdout);
+  if (dumpPath && !panel.dumpPpm(dumpPath)) {
+    fprintf(stderr, "sim: cannot write %s\n", dumpPath);
+  }
+  if (dumpAscii) {
+    panel.printAscii(stdout);
+  }
+  if (metricsPath) {
+    FILE *file = sim::metricsWriter() ? fopen(metricsPath, "w") : nullptr;
+    if (file) {
+      FilePrint out(file);
+      sim::metricsWriter()(out);
+      fclose(file);
+    } else {
+      fprintf(stderr, "sim: cannot write metrics to %s\n", metricsPath);
+    }
+  }
+  uint64_t requests = ntpServer.requests();
+  uint64_t dropped = ntpServer.dropped();
+  uint64_t mangled = ntpServer.mangled();
+  for (int i = 0; i < extraCount; i++) {
+    requests += extraServers[i].requests();
+    dropped += extraServers[i].dropped();
+    mangled += extraServers[i].mangled();
+  }
+  double seconds = sim::elapsedMicros() / 1e6;
+  uint64_t loopAllocations = sim::heapAllocations() - setupAllocations;
+  fprintf(stderr,
+          "sim: %.3f s simulated, %llu loop() calls, %llu NTP requests (%llu dropped, %llu mangled), %llu DNS lookups\n"
+          "sim: SPI %llu command bytes, %llu data bytes, %llu pixels written, first lit at %.3f s\n"
+          "sim: %llu heap allocations in loop(), %.2f per call, %llu NVS writes\n",
+          seconds, (unsigned long long)loops, (unsigned long long)requests,
+          (unsigned long long)dropped, (unsigned long long)mangled, (unsigned long long)sim::dnsLookups(),
+          (unsigned long long)panel.commandBytes(), (unsigned long long)panel.dataBytes(),
+          (unsigned long long)panel.pixelsWritten(), panel.firstLitMicros() / 1e6, (unsigned long long)loopAllocations,
+          loops ? (double)loopAllocations / loops : 0.0, (unsigned long long)sim::nvsWrites());
+  if (ntpLoadRate > 0) {
+    fprintf(stderr,
+            "sim: NTP load %llu requests, %llu answered (%llu unsynchronized, %llu invalid), %.0f replies/s\n"
+            "sim: served offset mean %.3f ms, mean |offset| %.3f ms, worst %.3f ms, mean delay %.3f ms\n",
+            (unsigned long long)ntpLoad.sent(), (unsigned long long)ntpLoad.answered(),
+            (unsigned long long)ntpLoad.unsynchronized(), (unsigned long long)ntpLoad.invalid(),
+            seconds > 0 ? ntpLoad.answered() / seconds : 0.0, ntpLoad.meanOffset() / 1000,
+            ntpLoad.meanAbsOffset() / 1000, ntpLoad.worstOffset() / 1000, ntpLoad.meanDelay() / 1000);
+  }
+}
+
+static void stop() {
+  report();
+  exit(0);
+}
+
+static void onSignal(int) { sim::requestStop(); }
+
+// HOST[:OFFSET_MS[:DELAY_MS]]; the name is kept in place, so value must outlive the run (argv does).
+static bool addExtraServer(char *value) {
+  if (extraCount == 3) {
+    return false;
+  }
+  FakeNtpServer &server = extraServers[extraCount];
+  char *offset = strchr(value, ':');
+  if (offset) {
+    *offset++ = '\0';
+    server.setOffsetMicros((int64_t)(atof(offset) * 1000));
+    char *delay = strchr(offset, ':');
+    if (delay) {
+      server.setDelayMicros((uint64_t)(atof(delay + 1) * 1000), (uint64_t)(atof(delay + 1) * 1000));
+    }
+  }
+  server.setSeed(0x9E3779B97F4A7C15ULL * (extraCount + 2));
+  extraNames[extraCount++] = value;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  bool realNtp = false;
+  double ntpJitter = 0;
+  double ntpLoss = 0;
+  double ntpFuzz = 0;
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!strcmp(arg, "--virtual-time")) {
+      sim::setVirtualTime(true);
+    } else if (!strcmp(arg, "--real-ntp")) {
+      realNtp = true;
+    } else if (!strcmp(arg, "--ascii")) {
+      dumpAscii = true;
+    } else if (value && !strcmp(arg, "--seconds")) {
+      sim::setRunLimit((uint64_t)(atof(value) * 1e6)), i++;
+    } else if (value && !strcmp(arg, "--epoch")) {
+      sim::setEpochMicros((uint64_t)(atof(value) * 1e6 + 0.5)), i++;
+    } else if (value && !strcmp(arg, "--drift-ppm")) {
+      sim::setDriftPpm(atof(value)), i++;
+    } else if (value && !strcmp(arg, "--uptime")) {
+      sim::setUptimeMicros((uint64_t)(atof(value) * 1e6)), i++;
+    } else if (value && !strcmp(arg, "--leap-insert")) {
+      sim::setLeapSecond((time_t)atoll(value), 1), i++;
+    } else if (value && !strcmp(arg, "--leap-delete")) {
+      sim::setLeapSecond((time_t)atoll(value), -1), i++;
+    } else if (value && !strcmp(arg, "--wifi-delay")) {
+      sim::setWiFiAssociationMillis(atol(value)), i++;
+    } else if (value && !strcmp(arg, "--wifi-up-at")) {
+      sim::setAccessPointUpMillis((long)(atof(value) * 1000)), i++;
+    } else if (value && !strcmp(arg, "--ntp-offset")) {
+      ntpServer.setOffsetMicros((int64_t)(atof(value) * 1000)), i++;
+    } else if (value && !strcmp(arg, "--ntp-delay")) {
+      ntpServer.setDelayMicros((uint64_t)(atof(value) * 1000), (uint64_t)(atof(value) * 1000)), i++;
+    } else if (value && !strcmp(arg, "--ntp-jitter")) {
+      ntpJitter = atof(value), i++;
+    } else if (value && !strcmp(arg, "--ntp-loss")) {
+      ntpLoss = atof(value), i++;
+    } else if (value && !strcmp(arg, "--ntp-fuzz")) {
+      ntpFuzz = atof(value), i++;
+    } else if (value && !strcmp(arg, "--ntp-server") && addExtraServer(value)) {
+      i++;
+    } else if (value && !strcmp(arg, "--dns-delay")) {
+      sim::setDnsDelayMillis(atol(value)), i++;
+    } else if (value && !strcmp(arg, "--dns-addresses")) {
+      sim::setDnsAddresses((uint8_t)atoi(value)), i++;
+    } else if (value && !strcmp(arg, "--dns-dead")) {
+      sim::setDnsDeadAddress(atoi(value)), i++;
+    } else if (value && !strcmp(arg, "--ntp-load")) {
+      ntpLoadRate = atof(value), i++;
+    } else if (value && !strcmp(arg, "--nvs")) {
+      sim::setNvsPath(value), i++;
+    } else if (value && !strcmp(arg, "--dump")) {
+      dumpPath = value, i++;
+    } else if (value && !strcmp(arg, "--metrics")) {
+      metricsPath = value, i++;
+    } else {
+      usage(argv[0]);
+      return strcmp(arg, "--help") ? 2 : 0;
+    }
+  }
+
+  if (!realNtp) {
+    uint16_t port = ntpServer.begin();
+    if (!port) {
+      fprintf(stderr, "sim: cannot start fake NTP server\n");
+      return 1;
+    }
+    sim::addRoute(nullptr, 123, port);
+    ntpServer.setJitterMicros((uint64_t)(ntpJitter * 1000));
+    ntpServer.setLossPercent(ntpLoss);
+    ntpServer.setFuzzPercent(ntpFuzz);
+    for (int i = 0; i < extraCount; i++) {
+      uint16_t extraPort = extraServers[i].begin();
+      if (!extraPort) {
+        fprintf(stderr, "sim: cannot start fake NTP server for %s\n", extraNames[i]);
+        return 1;
+      }
+      sim::addRoute(extraNames[i], 123, extraPort);
+      extraServers[i].setJitterMicros((uint64_t)(ntpJitter * 1000));
+      extraServers[i].setLossPercent(ntpLoss);
+      extraServers[i].setFuzzPercent(ntpFuzz);
+    }
+  }
+  if (ntpLoadRate > 0 && !ntpLoad.begin(ntpLoadRate)) {
+    fprintf(stderr, "sim: cannot start NTP load generator\n");
+    return 1;
+  }
+  sim::attachPinListener(&panel);
+  sim::setStopHandler(stop);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  setup();
+  setupAllocations = sim::heapAllocations();
+  for (;;) {
+    loop();
+    loops++;
+    sim::advance(0);
+  }
+}
+
+#endif
@@ -0,0 +1,387 @@
+/*
+  HostSim.cpp - simulated clock, service pump, pins and UDP routing.
+*/
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HostSim.h"
+
+namespace sim {
+
+namespace {
+
+struct Route {
+  std::string host; // empty matches any host
+  uint16_t port;
+  uint16_t localPort;
+};
+
+bool virtualMode = false;
+uint64_t virtualElapsed = 0;
+uint64_t epochMicros = 0;
+double driftPpm = 0;
+uint64_t uptimeMicros = 0; // device time already counted at start
+uint64_t leapAt = 0; // µs since 1970
+int leapDirection = 0;
+
+uint64_t runLimit = 0;
+void (*stopHandler)() = nullptr;
+volatile sig_atomic_t stopRequested = 0;
+
+std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+std::vector<Service *> services;
+PinListener *pinListener = nullptr;
+uint8_t pins[64];
+
+std::vector<Route> routes;
+long wifiAssociation = 1200;
+long accessPointUp = 0;
+
+// Stub DNS answers are 192.0.2.(route * 8 + member + 1).
+const uint32_t STUB_NET = 0xC0000200; // 192.0.2.0, host byte order
+long dnsDelay = 0;
+uint8_t dnsAddresses = 1;
+int dnsDead = -1;
+uint64_t lookups = 0;
+std::map<std::string, uint8_t> nextMember;
+
+std::vector<std::pair<uint16_t, uint16_t>> boundPorts; // requested, actual
+
+void (*metricsWriterFunction)(Print &out) = nullptr;
+
+// Host clock readings at which virtual time moved on, to map kernel timestamps back to it
+const unsigned HOST_MARKS = 64;
+int64_t hostMarkNanos[HOST_MARKS];
+uint64_t hostMarkElapsed[HOST_MARKS];
+unsigned hostMarkCount = 0;
+
+int64_t hostNanos(const struct timespec &t) { return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec; }
+
+void setVirtualElapsed(uint64_t elapsed) {
+  virtualElapsed = elapsed;
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  unsigned mark = hostMarkCount++ % HOST_MARKS;
+  hostMarkNanos[mark] = hostNanos(now);
+  hostMarkElapsed[mark] = elapsed;
+}
+
+uint64_t deviceMicrosAtElapsed(uint64_t elapsed) {
+  return uptimeMicros + elapsed + (int64_t)(elapsed * driftPpm * 1e-6);
+}
+
+void waitUntil(uint64_t elapsed) {
+  if (virtualMode) {
+    if (elapsed > virtualElapsed) {
+      setVirtualElapsed(elapsed);
+    }
+    return;
+  }
+  uint64_t now = elapsedMicros();
+  if (elapsed > now) {
+    std::this_thread::sleep_for(std::chrono::microseconds(elapsed - now));
+  }
+}
+
+uint64_t nextServiceEvent() {
+  uint64_t next = UINT64_MAX;
+  for (size_t i = 0; i < services.size(); i++) {
+    next = std::min(next, services[i]->nextEvent());
+  }
+  return next;
+}
+
+void checkRunLimit() {
+  if (!stopHandler || !(stopRequested || (runLimit && elapsedMicros() >= runLimit))) {
+    return;
+  }
+  void (*onStop)() = stopHandler;
+  stopHandler = nullptr;
+  onStop();
+}
+
+const Route *findRoute(const char *host, uint16_t port) {
+  const Route *match = nullptr;
+  for (size_t i = 0; i < routes.size(); i++) {
+    if (routes[i].port != port) {
+      continue;
+    }
+    if (routes[i].host == host) {
+      match = &routes[i];
+      break;
+    }
+    if (routes[i].host.empty() && !match) {
+      match = &routes[i];
+    }
+  }
+  return match;
+}
+
+bool hostLookup(const char *host, uint32_t &address) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  struct addrinfo *result = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) {
+    return false;
+  }
+  address = ((struct sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
+  freeaddrinfo(result);
+  return true;
+}
+
+bool isDottedQuad(const char *host) {
+  struct in_addr parsed;
+  return inet_pton(AF_INET, host, &parsed) == 1;
+}
+
+} // namespace
+
+void setVirtualTime(bool enabled) {
+  setVirtualElapsed(elapsedMicros());
+  virtualMode = enabled;
+}
+
+bool virtualTime() { return virtualMode; }
+
+void setEpoch(time_t epoch) {
+  epochMicros = (uint64_t)epoch * 1000000ULL;
+}
+
+void setEpochMicros(uint64_t epoch) { epochMicros = epoch; }
+
+void setDriftPpm(double ppm) { driftPpm = ppm; }
+
+uint64_t elapsedMicros() {
+  if (virtualMode) {
+    return virtualElapsed;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint64_t utcMicros() { return utcMicrosAt(elapsedMicros()); }
+
+uint64_t utcMicrosAt(uint64_t elapsed) {
+  if (epochMicros == 0) {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    epochMicros = (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec - elapsedMicros();
+  }
+  // The epoch is given in POSIX time, so the leap shifts what comes after it
+  uint64_t utc = epochMicros + elapsed;
+  if (leapDirection > 0 && utc >= leapAt && epochMicros < leapAt) {
+    utc -= 1000000;
+  } else if (leapDirection < 0 && utc >= leapAt - 1000000 && epochMicros < leapAt - 1000000) {
+    utc += 1000000;
+  }
+  return utc;
+}
+
+void setLeapSecond(time_t at, int direction) {
+  leapAt = (uint64_t)at * 1000000ULL;
+  leapDirection = direction;
+}
+
+uint8_t leapIndicatorAt(uint64_t elapsed) {
+  uint64_t utc = utcMicrosAt(elapsed);
+  if (!leapDirection || utc >= leapAt || utc + 86400000000ULL < leapAt) {
+    return 0;
+  }
+  return leapDirection > 0 ? 1 : 2;
+}
+
+uint64_t deviceMicros() { return deviceMicrosAtElapsed(elapsedMicros()); }
+
+void setUptimeMicros(uint64_t us) { uptimeMicros = us; }
+
+uint64_t deviceToElapsedMicros(uint64_t us) {
+  return (uint64_t)(us / (1 + driftPpm * 1e-6) + 0.5);
+}
+
+uint64_t deviceMicrosAtHostTime(const struct timespec &t) {
+  int64_t at = hostNanos(t);
+  uint64_t elapsed = elapsedMicros();
+  if (virtualMode) {
+    // The newest mark at or before t; the oldest one kept if t is older still
+    unsigned kept = std::min(hostMarkCount, HOST_MARKS);
+    for (unsigned k = 1; k <= kept; k++) {
+      unsigned mark = (hostMarkCount - k) % HOST_MARKS;
+      elapsed = hostMarkElapsed[mark];
+      if (hostMarkNanos[mark] <= at) {
+        break;
+      }
+    }
+  } else {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t ago = (hostNanos(now) - at) / 1000;
+    if (ago > 0) {
+      elapsed -= std::min((uint64_t)ago, elapsed);
+    }
+  }
+  return deviceMicrosAtElapsed(elapsed);
+}
+
+void advance(uint64_t us) {
+  uint64_t target = elapsedMicros() + us;
+  uint64_t next;
+  while ((next = nextServiceEvent()) < target && next > elapsedMicros()) {
+    waitUntil(next);
+    pump();
+  }
+  waitUntil(target);
+  pump();
+  checkRunLimit();
+}
+
+void setRunLimit(uint64_t us) { runLimit = us; }
+
+void setStopHandler(void (*onStop)()) { stopHandler = onStop; }
+
+void requestStop() { stopRequested = 1; }
+
+void addService(Service *service) { services.push_back(service); }
+
+void removeService(Service *service) {
+  for (size_t i = 0; i < services.size(); i++) {
+    if (services[i] == service) {
+      services.erase(services.begin() + i);
+      return;
+    }
+  }
+}
+
+void pump() {
+  UncountedAllocations uncounted; // The services stand in for the network
+  for (size_t i = 0; i < services.size(); i++) {
+    services[i]->poll();
+  }
+}
+
+void attachPinListener(PinListener *listener) { pinListener = listener; }
+
+uint8_t pinState(uint8_t pin) { return pin < sizeof(pins) ? pins[pin] : 0; }
+
+void setPin(uint8_t pin, uint8_t value) {
+  if (pin >= sizeof(pins)) {
+    return;
+  }
+  pins[pin] = value;
+  if (pinListener) {
+    pinListener->pinChanged(pin, value);
+  }
+}
+
+void addRoute(const char *host, uint16_t port, uint16_t localPort) {
+  routes.push_back(Route{host ? host : "", port, localPort});
+}
+
+bool resolve(const char *host, uint16_t port, uint32_t &address, uint16_t &resolvedPort) {
+  uint32_t looked = 0;
+  if (isDottedQuad(host)) {
+    inet_pton(AF_INET, host, &looked);
+  } else if (!lookup(host, looked)) {
+    return false;
+  }
+  return resolveAddress(looked, port, address, resolvedPort);
+}
+
+bool resolveAddress(uint32_t host, uint16_t port, uint32_t &address, uint16_t &resolvedPort) {
+  uint32_t stub = ntohl(host);
+  if ((stub & 0xFFFFFF00) == STUB_NET && (stub & 0xFF) != 0 && (stub & 0xFF) <= routes.size() * 8) {
+    size_t route = ((stub & 0xFF) - 1) / 8;
+    int member = ((stub & 0xFF) - 1) % 8;
+    address = htonl(INADDR_LOOPBACK);
+    // The discard port: a dead member swallows requests without an answer
+    resolvedPort = member == dnsDead ? 9 : routes[route].localPort;
+    return true;
+  }
+
+  char dotted[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &host, dotted, sizeof(dotted));
+  const Route *match = findRoute(dotted, port);
+  address = match ? htonl(INADDR_LOOPBACK) : host;
+  resolvedPort = match ? match->localPort : port;
+  if (!match && stub >> 24 == 127) {
+    // Loopback: whoever the sketch reaches there on a privileged port is bound elsewhere
+    uint16_t bound = boundPort(port);
+    resolvedPort = bound ? bound : port;
+  }
+  return true;
+}
+
+void setBoundPort(uint16_t port, uint16_t bound) {
+  UncountedAllocations uncounted;
+  for (size_t i = 0; i < boundPorts.size(); i++) {
+    if (boundPorts[i].first == port) {
+      boundPorts[i].second = bound;
+      return;
+    }
+  }
+  boundPorts.push_back(std::make_pair(port, bound));
+}
+
+uint16_t boundPort(uint16_t port) {
+  for (size_t i = 0; i < boundPorts.size(); i++) {
+    if (boundPorts[i].first == port) {
+      return boundPorts[i].second;
+    }
+  }
+  return 0;
+}
+
+bool lookup(const char *host, uint32_t &address) {
+  UncountedAllocations uncounted;
+  if (isDottedQuad(host)) {
+    return inet_pton(AF_INET, host, &address) == 1;
+  }
+  const Route *match = nullptr;
+  for (size_t i = 0; i < routes.size() && !match; i++) {
+    match = findRoute(host, routes[i].port);
+  }
+  if (!match) {
+    return hostLookup(host, address);
+  }
+
+  lookups++;
+  advance((uint64_t)dnsDelay * 1000);
+  uint8_t &member = nextMember[host];
+  address = htonl(STUB_NET + (match - &routes[0]) * 8 + member + 1);
+  member = (member + 1) % dnsAddresses;
+  return true;
+}
+
+void setDnsDelayMillis(long ms) { dnsDelay = ms; }
+
+void setDnsAddresses(uint8_t count) { dnsAddresses = count < 1 ? 1 : count > 8 ? 8 : count; }
+
+void setDnsDeadAddress(int index) { dnsDead = index; }
+
+uint64_t dnsLookups() { return lookups; }
+
+void setWiFiAssociationMillis(long ms) { wifiAssociation = ms; }
+
+long wifiAssociationMillis() { return wifiAssociation; }
+
+void setAccessPointUpMillis(long ms) { accessPointUp = ms; }
+
+long accessPointUpMillis() { return accessPointUp; }
+
+void setMetricsWriter(void (*writer)(Print &out)) { metricsWriterFunction = writer; }
+
+void (*metricsWriter())(Print &out) { return metricsWriterFunction; }
+
+} // namespace sim
@@ -0,0 +1,227 @@
+/*
+  HostSim.h - the simulated world the host build runs in.
+
+  One thread drives everything: the sketch calls delay()/parsePacket(),
+  those advance the simulated clock and pump the registered services
+  (fake NTP servers, ...), so runs are deterministic in virtual-time mode
+  and behave like the device in real-time mode.
+*/
+#ifndef HostSim_h
+#define HostSim_h
+
+#include <stdint.h>
+#include <time.h>
+
+class Print;
+
+namespace sim {
+
+// ---- Time -----------------------------------------------------------------
+
+/**
+ * In virtual-time mode delay() advances the clock instantly instead of
+ * sleeping, so hours of device time run in seconds of host time.
+ */
+void setVirtualTime(bool enabled);
+bool virtualTime();
+
+/**
+ * UTC instant at which the simulation starts (defaults to the host clock).
+ */
+void setEpoch(time_t epoch);
+void setEpochMicros(uint64_t epoch);
+
+/**
+ * Frequency error of the device crystal; applied to millis()/micros() only,
+ * never to the "true" clocks below.
+ */
+void setDriftPpm(double ppm);
+
+/**
+ * True time elapsed since the simulation started, in µs.
+ */
+uint64_t elapsedMicros();
+
+/**
+ * True UTC in µs since 1970, what a perfect NTP server would report. Like
+ * POSIX time it has no room for leap seconds: an inserted one repeats the
+ * last second of its day, a deleted one skips it.
+ */
+uint64_t utcMicros();
+uint64_t utcMicrosAt(uint64_t elapsed); // at that elapsedMicros()
+
+/**
+ * A leap second ending at the UTC midnight at (unix seconds): +1 inserts
+ * 23:59:60, -1 deletes 23:59:59, 0 clears it. Servers announce it with
+ * leapIndicatorAt() during the 24 hours before.
+ */
+void setLeapSecond(time_t at, int direction);
+uint8_t leapIndicatorAt(uint64_t elapsed); // 0 none, 1 insert, 2 delete
+
+/**
+ * What the device's own timebase reads, in µs since boot (drift applied).
+ */
+uint64_t deviceMicros();
+
+/**
+ * Start as if the device had been up for us µs already, e.g. just short
+ * of the 49.7-day millis() wrap.
+ */
+void setUptimeMicros(uint64_t us);
+
+/**
+ * True time that passes while the device's own timebase counts us µs.
+ */
+uint64_t deviceToElapsedMicros(uint64_t us);
+
+/**
+ * What deviceMicros() read when the host clock (CLOCK_REALTIME) showed t,
+ * e.g. a kernel receive timestamp. In virtual-time mode that is the
+ * simulated instant the host was at then; the last 64 are remembered.
+ */
+uint64_t deviceMicrosAtHostTime(const struct timespec &t);
+
+/**
+ * Let time pass: sleeps in real-time mode, jumps in virtual-time mode.
+ * Services are pumped at the end and at each service's nextEvent() on
+ * the way, so what they send goes out on time.
+ */
+void advance(uint64_t us);
+
+/**
+ * Stop the run once this much simulated time has elapsed (0 = never) or
+ * requestStop() was called; onStop runs from inside advance() and is
+ * expected not to return.
+ */
+void setRunLimit(uint64_t us);
+void setStopHandler(void (*onStop)());
+void requestStop(); // async-signal-safe
+
+// ---- Heap -----------------------------------------------------------------
+
+/**
+ * Number of operator new calls so far (String, containers, ...).
+ */
+uint64_t heapAllocations();
+
+/**
+ * Scope in which operator new calls are not counted: the simulator's own
+ * containers (reply queues, the NVS map, the stub DNS) are not the
+ * sketch's allocations and have no counterpart on the device.
+ */
+class UncountedAllocations {
+public:
+  UncountedAllocations();
+  ~UncountedAllocations();
+};
+
+// ---- Services -------------------------------------------------------------
+
+/**
+ * Anything that has to make progress while the sketch waits.
+ */
+class Service {
+public:
+  virtual ~Service() {}
+  virtual void poll() = 0;
+
+  /**
+   * elapsedMicros() at which poll() next has something to do on its own,
+   * UINT64_MAX if nothing is scheduled.
+   */
+  virtual uint64_t nextEvent() const { return UINT64_MAX; }
+};
+
+void addService(Service *service);
+void removeService(Service *service);
+void pump();
+
+// ---- Pins -----------------------------------------------------------------
+
+class PinListener {
+public:
+  virtual ~PinListener() {}
+  virtual void pinChanged(uint8_t pin, uint8_t value) = 0;
+};
+
+void attachPinListener(PinListener *listener);
+void setPin(uint8_t pin, uint8_t value);
+uint8_t pinState(uint8_t pin);
+
+// ---- Network --------------------------------------------------------------
+
+/**
+ * Divert datagrams for host:port to a responder on 127.0.0.1:localPort.
+ * host may be nullptr to match any destination on that port.
+ */
+void addRoute(const char *host, uint16_t port, uint16_t localPort);
+
+/**
+ * Resolve a UDP destination, applying routes first. Names are looked up
+ * with lookup() and so pay its delay, like beginPacket(host) on the device.
+ * Returns false when the name cannot be resolved. address is in network
+ * byte order.
+ */
+bool resolve(const char *host, uint16_t port, uint32_t &address, uint16_t &resolvedPort);
+
+/**
+ * Same for a destination given as an address (network byte order), without
+ * going through a string.
+ */
+bool resolveAddress(uint32_t host, uint16_t port, uint32_t &address, uint16_t &resolvedPort);
+
+/**
+ * Ports the sketch listens on. Privileged ones (below 1024) are bound to an
+ * ephemeral port instead; boundPort() tells which, 0 if nothing listens.
+ */
+void setBoundPort(uint16_t port, uint16_t boundPort);
+uint16_t boundPort(uint16_t port);
+
+/**
+ * Stub DNS. A name with a route (or any name, given a wildcard route)
+ * resolves to one of dnsAddresses stand-in addresses in 192.0.2.0/24 that
+ * lead back to its responder, handed out round-robin one per lookup, like a
+ * pool with that many members. Every lookup blocks for the configured delay.
+ * Names without a route go to the host resolver.
+ */
+bool lookup(const char *host, uint32_t &address);
+void setDnsDelayMillis(long ms);
+void setDnsAddresses(uint8_t count); // 1-8 per name
+void setDnsDeadAddress(int index);   // this member of every name never answers, -1 for none
+uint64_t dnsLookups();
+
+/**
+ * Time Wi-Fi association takes; a negative value never connects.
+ */
+void setWiFiAssociationMillis(long ms);
+long wifiAssociationMillis();
+
+/**
+ * The access point only comes up this long into the run; attempts before
+ * that associate no earlier than it is up plus the association time.
+ */
+void setAccessPointUpMillis(long ms);
+long accessPointUpMillis();
+
+// ---- Flash ----------------------------------------------------------------
+
+/**
+ * File the Preferences (NVS) stand-in keeps its contents in, nullptr for a
+ * blank store every run. Runs sharing a file see each other's writes like
+ * boots of one device.
+ */
+void setNvsPath(const char *path);
+uint64_t nvsWrites();
+
+// ---- Reports --------------------------------------------------------------
+
+/**
+ * How the sketch's metrics registry writes itself out as JSON; the exit
+ * report calls it for --metrics. nullptr until the registry registers.
+ */
+void setMetricsWriter(void (*writer)(Print &out));
+void (*metricsWriter())(Print &out);
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,26 @@
+/*
+  IPAddress.cpp - dotted-quad parsing and formatting.
+*/
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+bool IPAddress::fromString(const char *address) {
+  unsigned int a, b, c, d;
+  char tail;
+  if (sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+    return false;
+  }
+  _address[0] = a;
+  _address[1] = b;
+  _address[2] = c;
+  _address[3] = d;
+  return true;
+}
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _address[0], _address[1], _address[2], _address[3]);
+  return String(buf);
+}
@@ -0,0 +1,38 @@
+/*
+  IPAddress.h - IPv4 address value type as used by the UDP API.
+*/
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include <stdint.h>
+#include <string.h>
+
+#include "WString.h"
+
+class IPAddress {
+public:
+  IPAddress() : _address{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address{a, b, c, d} {}
+  // Network byte order, as stored in in_addr.s_addr.
+  IPAddress(uint32_t address) { memcpy(_address, &address, sizeof(_address)); }
+
+  operator uint32_t() const {
+    uint32_t address;
+    memcpy(&address, _address, sizeof(address));
+    return address;
+  }
+  bool operator==(const IPAddress &other) const { return (uint32_t)*this == (uint32_t)other; }
+  bool operator!=(const IPAddress &other) const { return !(*this == other); }
+  uint8_t operator[](int index) const { return _address[index]; }
+  uint8_t &operator[](int index) { return _address[index]; }
+
+  bool fromString(const char *address);
+  String toString() const;
+
+  uint8_t *raw_address() { return _address; }
+
+private:
+  uint8_t _address[4];
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*
+  NtpLoadGenerator.cpp - SNTP client load over a loopback socket.
+*/
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "NtpLoadGenerator.h"
+
+static const uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+
+static void putTimestamp(uint8_t *p, uint64_t unixMicros) {
+  uint64_t seconds = unixMicros / 1000000 + NTP_UNIX_OFFSET;
+  uint64_t fraction = ((unixMicros % 1000000) << 32) / 1000000;
+  for (int i = 0; i < 4; i++) {
+    p[i] = seconds >> (24 - 8 * i);
+    p[4 + i] = fraction >> (24 - 8 * i);
+  }
+}
+
+static int64_t getTimestamp(const uint8_t *p) {
+  uint64_t seconds = (uint64_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+  uint64_t fraction = (uint64_t)p[4] << 24 | p[5] << 16 | p[6] << 8 | p[7];
+  seconds += seconds & 0x80000000 ? 0 : 0x100000000ULL; // era 1 from 2036 on (RFC 4330)
+  return (int64_t)((seconds - NTP_UNIX_OFFSET) * 1000000 + ((fraction * 1000000 + 0x80000000ULL) >> 32));
+}
+
+NtpLoadGenerator::~NtpLoadGenerator() { end(); }
+
+bool NtpLoadGenerator::begin(double rate) {
+  _fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (_fd < 0) {
+    return false;
+  }
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+  _rate = rate;
+  _startedAt = sim::elapsedMicros();
+  sim::addService(this);
+  return true;
+}
+
+void NtpLoadGenerator::end() {
+  if (_fd >= 0) {
+    sim::removeService(this);
+    close(_fd);
+    _fd = -1;
+  }
+}
+
+void NtpLoadGenerator::poll() {
+  if (_fd < 0) {
+    return;
+  }
+  receive();
+
+  uint16_t port = sim::boundPort(123);
+  if (!port) {
+    _startedAt = sim::elapsedMicros(); // the clock starts once the sketch has bound its server
+    return;
+  }
+  uint64_t due = (uint64_t)((sim::elapsedMicros() - _startedAt) * 1e-6 * _rate);
+  for (uint64_t n = 0; _sent < due && n < MAX_PER_POLL; n++) {
+    send(port);
+  }
+}
+
+void NtpLoadGenerator::send(uint16_t port) {
+  uint8_t request[48];
+  memset(request, 0, sizeof(request));
+  request[0] = 0x23; // LI 0, version 4, mode 3 (client)
+  putTimestamp(request + 40, sim::utcMicros());
+
+  struct sockaddr_in to = {};
+  to.sin_family = AF_INET;
+  to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  to.sin_port = htons(port);
+  sendto(_fd, request, sizeof(request), 0, (struct sockaddr *)&to, sizeof(to));
+  _sent++;
+}
+
+void NtpLoadGenerator::receive() {
+  uint8_t reply[68];
+  ssize_t len;
+  while ((len = recv(_fd, reply, sizeof(reply), 0)) > 0) {
+    int64_t t4 = sim::utcMicros();
+    _answered++;
+    if (len < 48 || (reply[0] & 0x07) != 4) {
+      _invalid++;
+      continue;
+    }
+    if (reply[0] >> 6 == 3 || reply[1] == 0 || reply[1] >= 16) {
+      _unsynchronized++;
+      continue;
+    }
+    // The originate timestamp is our own transmit time, so the reply carries everything needed
+    int64_t t1 = getTimestamp(reply + 24);
+    int64_t t2 = getTimestamp(reply + 32);
+    int64_t t3 = getTimestamp(reply + 40);
+    if (t1 > t4 || t3 < t2) {
+      _invalid++;
+      continue;
+    }
+    double offset = ((t2 - t1) + (t3 - t4)) / 2.0;
+    _scored++;
+    _offsetSum += offset;
+    _absOffsetSum += fabs(offset);
+    _worstOffset = fmax(_worstOffset, fabs(offset));
+    _delaySum += (t4 - t1) - (t3 - t2);
+  }
+}
@@ -0,0 +1,60 @@
+/*
+  NtpLoadGenerator.h - floods the sketch's own NTP server with client
+  requests and scores the replies.
+
+  Sends requests to whatever the sketch bound on port 123 at a fixed rate
+  of simulated time, timestamped with the true clock, so the offset each
+  reply yields is the error of the time the sketch serves. Fixed buffers
+  only: it adds nothing to the heap counters.
+*/
+#ifndef NtpLoadGenerator_h
+#define NtpLoadGenerator_h
+
+#include <stdint.h>
+
+#include "HostSim.h"
+
+class NtpLoadGenerator : public sim::Service {
+public:
+  ~NtpLoadGenerator();
+
+  /**
+   * Start sending rate requests per simulated second from sim::pump().
+   */
+  bool begin(double rate);
+  void end();
+
+  uint64_t sent() const { return _sent; }
+  uint64_t answered() const { return _answered; }
+  uint64_t unsynchronized() const { return _unsynchronized; }
+  uint64_t invalid() const { return _invalid; }
+
+  // Over the synchronized replies, in µs
+  double meanOffset() const { return _scored ? _offsetSum / _scored : 0; }
+  double meanAbsOffset() const { return _scored ? _absOffsetSum / _scored : 0; }
+  double worstOffset() const { return _worstOffset; }
+  double meanDelay() const { return _scored ? _delaySum / _scored : 0; }
+
+  void poll() override;
+
+private:
+  static const uint64_t MAX_PER_POLL = 1000;
+
+  int _fd = -1;
+  double _rate = 0;
+  uint64_t _startedAt = 0;
+  uint64_t _sent = 0;
+  uint64_t _answered = 0;
+  uint64_t _unsynchronized = 0;
+  uint64_t _invalid = 0;
+  uint64_t _scored = 0;
+  double _offsetSum = 0;
+  double _absOffsetSum = 0;
+  double _worstOffset = 0;
+  double _delaySum = 0;
+
+  void send(uint16_t port);
+  void receive();
+};
+
+#endif
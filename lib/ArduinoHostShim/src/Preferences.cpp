@@ -0,0 +1,178 @@
+/*
+  Preferences.cpp - NVS stand-in: one map for all namespaces, written out
+  as a whole on every change, the way each put() commits on the device.
+*/
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "HostSim.h"
+#include "Preferences.h"
+
+namespace {
+
+// namespace + '\0' + key -> value
+std::map<std::string, std::vector<uint8_t>> entries;
+const char *nvsPath = nullptr;
+bool loaded = false;
+uint64_t writes = 0;
+
+std::string entryKey(const char *name, const char *key) { return std::string(name) + '\0' + key; }
+
+// Records of: key length (2 bytes), key, value length (2 bytes), value
+void load() {
+  loaded = true;
+  FILE *file = nvsPath ? fopen(nvsPath, "rb") : nullptr;
+  if (!file) {
+    return;
+  }
+  uint8_t length[2];
+  while (fread(length, 1, 2, file) == 2) {
+    std::string key(length[0] | length[1] << 8, '\0');
+    if (fread(&key[0], 1, key.size(), file) != key.size() || fread(length, 1, 2, file) != 2) {
+      break;
+    }
+    std::vector<uint8_t> value(length[0] | length[1] << 8);
+    if (fread(value.data(), 1, value.size(), file) != value.size()) {
+      break;
+    }
+    entries[key] = value;
+  }
+  fclose(file);
+}
+
+void save() {
+  writes++;
+  FILE *file = nvsPath ? fopen(nvsPath, "wb") : nullptr;
+  if (!file) {
+    return;
+  }
+  for (const auto &entry : entries) {
+    uint8_t keyLength[2] = {(uint8_t)entry.first.size(), (uint8_t)(entry.first.size() >> 8)};
+    uint8_t valueLength[2] = {(uint8_t)entry.second.size(), (uint8_t)(entry.second.size() >> 8)};
+    fwrite(keyLength, 1, 2, file);
+    fwrite(entry.first.data(), 1, entry.first.size(), file);
+    fwrite(valueLength, 1, 2, file);
+    fwrite(entry.second.data(), 1, entry.second.size(), file);
+  }
+  fclose(file);
+}
+
+} // namespace
+
+namespace sim {
+
+void setNvsPath(const char *path) {
+  nvsPath = path;
+  loaded = false;
+  entries.clear();
+}
+
+uint64_t nvsWrites() { return writes; }
+
+} // namespace sim
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partitionLabel) {
+  sim::UncountedAllocations uncounted;
+  (void)partitionLabel;
+  if (_started || !name || strlen(name) >= sizeof(_name)) {
+    return false;
+  }
+  if (!loaded) {
+    load();
+  }
+  strcpy(_name, name);
+  _readOnly = readOnly;
+  _started = true;
+  return true;
+}
+
+void Preferences::end() { _started = false; }
+
+bool Preferences::clear() {
+  sim::UncountedAllocations uncounted;
+  if (!_started || _readOnly) {
+    return false;
+  }
+  std::string prefix = entryKey(_name, "");
+  for (auto entry = entries.begin(); entry != entries.end();) {
+    entry = entry->first.compare(0, prefix.size(), prefix) == 0 ? entries.erase(entry) : std::next(entry);
+  }
+  save();
+  return true;
+}
+
+bool Preferences::remove(const char *key) {
+  sim::UncountedAllocations uncounted;
+  if (!_started || _readOnly || !entries.erase(entryKey(_name, key))) {
+    return false;
+  }
+  save();
+  return true;
+}
+
+bool Preferences::isKey(const char *key) {
+  sim::UncountedAllocations uncounted;
+  return _started && entries.count(entryKey(_name, key));
+}
+
+size_t Preferences::put(const char *key, const void *value, size_t len) {
+  sim::UncountedAllocations uncounted;
+  if (!_started || _readOnly || !key || strlen(key) > 15) {
+    return 0;
+  }
+  const uint8_t *bytes = (const uint8_t *)value;
+  entries[entryKey(_name, key)] = std::vector<uint8_t>(bytes, bytes + len);
+  save();
+  return len;
+}
+
+bool Preferences::get(const char *key, void *value, size_t len) {
+  sim::UncountedAllocations uncounted;
+  auto entry = _started ? entries.find(entryKey(_name, key)) : entries.end();
+  if (entry == entries.end() || entry->second.size() != len) {
+    return false;
+  }
+  memcpy(value, entry->second.data(), len);
+  return true;
+}
+
+size_t Preferences::putUChar(const char *key, uint8_t value) { return put(key, &value, sizeof(value)); }
+
+size_t Preferences::putULong64(const char *key, uint64_t value) { return put(key, &value, sizeof(value)); }
+
+size_t Preferences::putDouble(const char *key, double value) { return put(key, &value, sizeof(value)); }
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) { return put(key, value, len); }
+
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue) {
+  uint8_t value;
+  return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+uint64_t Preferences::getULong64(const char *key, uint64_t defaultValue) {
+  uint64_t value;
+  return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+double Preferences::getDouble(const char *key, double defaultValue) {
+  double value;
+  return get(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  sim::UncountedAllocations uncounted;
+  auto entry = _started ? entries.find(entryKey(_name, key)) : entries.end();
+  return entry == entries.end() ? 0 : entry->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+  size_t len = getBytesLength(key);
+  if (!len || len > maxLen) {
+    return 0;
+  }
+  get(key, buf, len);
+  return len;
+}
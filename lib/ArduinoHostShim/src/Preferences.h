@@ -0,0 +1,41 @@
+/*
+  Preferences.h - the ESP32 core's NVS key-value store, kept in a file
+  (see sim::setNvsPath) so it survives from one run to the next like
+  flash survives a reboot. Without a file every run starts blank, like a
+  freshly erased device.
+*/
+#ifndef Preferences_h
+#define Preferences_h
+
+#include "Arduino.h"
+
+class Preferences {
+public:
+  bool begin(const char *name, bool readOnly = false, const char *partitionLabel = nullptr);
+  void end();
+
+  bool clear();
+  bool remove(const char *key);
+  bool isKey(const char *key);
+
+  size_t putUChar(const char *key, uint8_t value);
+  size_t putULong64(const char *key, uint64_t value);
+  size_t putDouble(const char *key, double value);
+  size_t putBytes(const char *key, const void *value, size_t len);
+
+  uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+  uint64_t getULong64(const char *key, uint64_t defaultValue = 0);
+  double getDouble(const char *key, double defaultValue = NAN);
+  size_t getBytesLength(const char *key);
+  size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+private:
+  char _name[16] = {0}; // NVS namespaces are at most 15 characters
+  bool _started = false;
+  bool _readOnly = false;
+
+  size_t put(const char *key, const void *value, size_t len);
+  bool get(const char *key, void *value, size_t len);
+};
+
+#endif
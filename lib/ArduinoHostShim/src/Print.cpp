@@ -0,0 +1,78 @@
+/*
+  Print.cpp - host implementation of the Arduino Print formatting helpers.
+*/
+#include <stdarg.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <algorithm>
+
+#include "Print.h"
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) {
+    return 0;
+  }
+  return write((const uint8_t *)buf, std::min((size_t)len, sizeof(buf) - 1));
+}
+
+static size_t printNumber(Print &p, unsigned long long n, int base, bool negative) {
+  char buf[8 * sizeof(n) + 2];
+  char *str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+  if (base < 2) {
+    base = 10;
+  }
+  do {
+    unsigned digit = n % base;
+    n /= base;
+    *--str = digit < 10 ? '0' + digit : 'A' + digit - 10;
+  } while (n);
+  if (negative) {
+    *--str = '-';
+  }
+  return p.write(str);
+}
+
+size_t Print::print(const String &s) { return write(s.c_str(), s.length()); }
+size_t Print::print(const char str[]) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char b, int base) { return print((unsigned long long)b, base); }
+size_t Print::print(unsigned int n, int base) { return print((unsigned long long)n, base); }
+size_t Print::print(unsigned long n, int base) { return print((unsigned long long)n, base); }
+size_t Print::print(int n, int base) { return print((long long)n, base); }
+size_t Print::print(long n, int base) { return print((long long)n, base); }
+
+size_t Print::print(long long n, int base) {
+  if (base == 10 && n < 0) {
+    return printNumber(*this, -(unsigned long long)n, 10, true);
+  }
+  return printNumber(*this, (unsigned long long)n, base, false);
+}
+
+size_t Print::print(unsigned long long n, int base) {
+  if (base == 0) {
+    return write((uint8_t)n);
+  }
+  return printNumber(*this, n, base, false);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::println() { return write("\r\n"); }
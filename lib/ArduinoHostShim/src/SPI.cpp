@@ -0,0 +1,8 @@
+/*
+  SPI.cpp - bus singletons.
+*/
+#include "SPI.h"
+#include "Wire.h"
+
+SPIClass SPI;
+TwoWire Wire;
@@ -0,0 +1,54 @@
+/*
+  SPI.h - hardware SPI is not simulated; the sketch drives the panel through
+  bit-banged pins. This keeps the Adafruit libraries compiling.
+*/
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#include "Arduino.h"
+
+#define SPI_HAS_TRANSACTION 1
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+
+class SPISettings {
+public:
+  SPISettings() {}
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+      : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+
+  uint32_t _clock = 1000000;
+  uint8_t _bitOrder = MSBFIRST;
+  uint8_t _dataMode = SPI_MODE0;
+};
+
+class SPIClass {
+public:
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings settings) { (void)settings; }
+  void endTransaction() {}
+  void setFrequency(uint32_t freq) { (void)freq; }
+  void setBitOrder(uint8_t bitOrder) { (void)bitOrder; }
+  void setDataMode(uint8_t dataMode) { (void)dataMode; }
+
+  uint8_t transfer(uint8_t data) { (void)data; return 0; }
+  uint16_t transfer16(uint16_t data) { (void)data; return 0; }
+  void transfer(void *buf, size_t count) { memset(buf, 0, count); }
+  void transferBytes(const uint8_t *data, uint8_t *out, uint32_t size) {
+    (void)data;
+    if (out) {
+      memset(out, 0, size);
+    }
+  }
+  void write(uint8_t data) { (void)data; }
+  void write16(uint16_t data) { (void)data; }
+  void write32(uint32_t data) { (void)data; }
+};
+
+extern SPIClass SPI;
+
+#endif
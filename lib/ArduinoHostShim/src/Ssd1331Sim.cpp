@@ -0,0 +1,172 @@
+/*
+  Ssd1331Sim.cpp - SSD1331 command decoder and framebuffer.
+*/
+#include <string.h>
+
+#include "Arduino.h"
+#include "Ssd1331Sim.h"
+
+// Number of parameter bytes following each command opcode (SSD1331
+// datasheet, table 9-1). Parameters are sent with D/C low like the opcode.
+static uint8_t commandParameters(uint8_t opcode) {
+  switch (opcode) {
+  case 0x15: case 0x75:                         // column / row address
+    return 2;
+  case 0x21:                                    // draw line
+    return 7;
+  case 0x22:                                    // draw rectangle
+    return 10;
+  case 0x23:                                    // copy
+    return 6;
+  case 0x24: case 0x25:                         // dim / clear window
+    return 4;
+  case 0x26:                                    // fill enable
+    return 1;
+  case 0x27:                                    // scroll setup
+    return 5;
+  case 0x81: case 0x82: case 0x83: case 0x87:   // contrast, master current
+  case 0x8A: case 0x8B: case 0x8C:              // second pre-charge
+  case 0xA0: case 0xA1: case 0xA2: case 0xA8:   // remap, start, offset, mux
+  case 0xAD: case 0xB0: case 0xB1: case 0xB3:   // master cfg, power, phase, clock
+  case 0xBB: case 0xBE:                         // pre-charge level, VCOMH
+    return 1;
+  case 0xAB:                                    // dim mode setting
+    return 5;
+  case 0xB8:                                    // gray scale table
+    return 32;
+  default:
+    return 0;
+  }
+}
+
+Ssd1331Sim::Ssd1331Sim(int8_t cs, int8_t dc, int8_t mosi, int8_t sck, int8_t rst)
+    : _cs(cs), _dc(dc), _mosi(mosi), _sck(sck), _rst(rst) {
+  reset();
+}
+
+void Ssd1331Sim::reset() {
+  _shift = _bits = 0;
+  _commandLength = _commandExpected = 0;
+  _colStart = _col = 0;
+  _colEnd = WIDTH - 1;
+  _rowStart = _row = 0;
+  _rowEnd = HEIGHT - 1;
+  _highByte = true;
+  memset(_framebuffer, 0, sizeof(_framebuffer));
+}
+
+void Ssd1331Sim::pinChanged(uint8_t pin, uint8_t value) {
+  if (pin == _rst) {
+    if (value == LOW) {
+      reset();
+    }
+    return;
+  }
+  if (pin == _cs) {
+    _shift = _bits = 0;
+    return;
+  }
+  if (pin != _sck || value != HIGH) {
+    return;
+  }
+  if (_cs >= 0 && sim::pinState(_cs) != LOW) {
+    return;
+  }
+  _shift = (_shift << 1) | (sim::pinState(_mosi) ? 1 : 0);
+  if (++_bits == 8) {
+    byteReceived(_shift, sim::pinState(_dc) == HIGH);
+    _shift = _bits = 0;
+  }
+}
+
+void Ssd1331Sim::byteReceived(uint8_t value, bool data) {
+  if (data) {
+    _dataBytes++;
+    if (_highByte) {
+      _pixelHigh = value;
+    } else {
+      writePixel((_pixelHigh << 8) | value);
+    }
+    _highByte = !_highByte;
+    return;
+  }
+
+  _commandBytes++;
+  if (_commandLength == 0) {
+    _commandExpected = commandParameters(value);
+  }
+  if (_commandLength < sizeof(_command)) {
+    _command[_commandLength] = value;
+  }
+  _commandLength++;
+  if (_commandLength > _commandExpected) {
+    executeCommand();
+    _commandLength = 0;
+  }
+}
+
+void Ssd1331Sim::executeCommand() {
+  switch (_command[0]) {
+  case 0x15:
+    _colStart = min<uint8_t>(_command[1], WIDTH - 1);
+    _colEnd = min<uint8_t>(_command[2], WIDTH - 1);
+    _col = _colStart;
+    _highByte = true;
+    break;
+  case 0x75:
+    _rowStart = min<uint8_t>(_command[1], HEIGHT - 1);
+    _rowEnd = min<uint8_t>(_command[2], HEIGHT - 1);
+    _row = _rowStart;
+    _highByte = true;
+    break;
+  case 0x25:
+    for (int y = _command[2]; y <= _command[4] && y < HEIGHT; y++) {
+      for (int x = _command[1]; x <= _command[3] && x < WIDTH; x++) {
+        _framebuffer[y][x] = 0;
+      }
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void Ssd1331Sim::writePixel(uint16_t color) {
+  _framebuffer[_row][_col] = color;
+  _pixelsWritten++;
+  if (color && !_firstLit) {
+    _firstLit = sim::elapsedMicros();
+  }
+  if (_col < _colEnd) {
+    _col++;
+    return;
+  }
+  _col = _colStart;
+  _row = _row < _rowEnd ? _row + 1 : _rowStart;
+}
+
+bool Ssd1331Sim::dumpPpm(const char *path) const {
+  FILE *out = fopen(path, "wb");
+  if (!out) {
+    return false;
+  }
+  fprintf(out, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      uint16_t c = _framebuffer[y][x];
+      uint8_t rgb[3] = {(uint8_t)((c >> 11) * 255 / 31), (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+                        (uint8_t)((c & 0x1F) * 255 / 31)};
+      fwrite(rgb, 1, sizeof(rgb), out);
+    }
+  }
+  return fclose(out) == 0;
+}
+
+void Ssd1331Sim::printAscii(FILE *out) const {
+  for (int y = 0; y < HEIGHT; y++) {
+    for (int x = 0; x < WIDTH; x++) {
+      fputc(_framebuffer[y][x] ? '#' : '.', out);
+    }
+    fputc('\n', out);
+  }
+}
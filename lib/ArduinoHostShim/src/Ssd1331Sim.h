@@ -0,0 +1,76 @@
+/*
+  Ssd1331Sim.h - pin-level model of a 96x64 SSD1331 OLED.
+
+  Watches the bit-banged SPI pins, reassembles command and data bytes and
+  keeps an RGB565 framebuffer, so whatever the sketch sends over the wire
+  ends up on the simulated glass. Counters make the SPI cost of a frame
+  visible.
+*/
+#ifndef Ssd1331Sim_h
+#define Ssd1331Sim_h
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "HostSim.h"
+
+class Ssd1331Sim : public sim::PinListener {
+public:
+  static const int WIDTH = 96;
+  static const int HEIGHT = 64;
+
+  Ssd1331Sim(int8_t cs, int8_t dc, int8_t mosi, int8_t sck, int8_t rst);
+
+  void pinChanged(uint8_t pin, uint8_t value) override;
+
+  uint16_t pixel(int x, int y) const { return _framebuffer[y][x]; }
+
+  /**
+   * Write the panel contents as a binary PPM image.
+   */
+  bool dumpPpm(const char *path) const;
+
+  /**
+   * Render the panel to a terminal, one character per pixel.
+   */
+  void printAscii(FILE *out) const;
+
+  uint64_t commandBytes() const { return _commandBytes; }
+  uint64_t dataBytes() const { return _dataBytes; }
+  uint64_t pixelsWritten() const { return _pixelsWritten; }
+  /**
+   * Simulated time the first lit pixel was written, in µs; 0 while the
+   * glass is still dark.
+   */
+  uint64_t firstLitMicros() const { return _firstLit; }
+
+private:
+  int8_t _cs, _dc, _mosi, _sck, _rst;
+
+  uint8_t _shift = 0;
+  uint8_t _bits = 0;
+
+  uint8_t _command[12];
+  uint8_t _commandLength = 0;
+  uint8_t _commandExpected = 0;
+
+  uint8_t _colStart = 0, _colEnd = WIDTH - 1;
+  uint8_t _rowStart = 0, _rowEnd = HEIGHT - 1;
+  uint8_t _col = 0, _row = 0;
+  bool _highByte = true;
+  uint8_t _pixelHigh = 0;
+
+  uint64_t _commandBytes = 0;
+  uint64_t _dataBytes = 0;
+  uint64_t _pixelsWritten = 0;
+  uint64_t _firstLit = 0;
+
+  uint16_t _framebuffer[HEIGHT][WIDTH];
+
+  void reset();
+  void byteReceived(uint8_t value, bool data);
+  void executeCommand();
+  void writePixel(uint16_t color);
+};
+
+#endif
@@ -0,0 +1,16 @@
+/*
+  Stream.h - byte-oriented input on top of Print.
+*/
+#ifndef Stream_h
+#define Stream_h
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+#endif
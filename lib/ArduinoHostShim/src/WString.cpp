@@ -0,0 +1,165 @@
+/*
+  WString.cpp - host implementation of the Arduino String conversions.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <utility>
+
+#include "WString.h"
+
+// Writes value into the tail of buf and returns where the digits start.
+static const char *toBase(char (&buf)[8 * sizeof(unsigned long long) + 2], unsigned long long value,
+                          unsigned char base, bool negative) {
+  char *str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+  if (base < 2) {
+    base = 10;
+  }
+  do {
+    unsigned digit = value % base;
+    value /= base;
+    *--str = digit < 10 ? '0' + digit : 'a' + digit - 10;
+  } while (value);
+  if (negative) {
+    *--str = '-';
+  }
+  return str;
+}
+
+void String::assignNumber(long long value, unsigned char base) {
+  if (base == 10 && value < 0) {
+    assignNumber(-(unsigned long long)value, base, true);
+  } else {
+    assignNumber((unsigned long long)value, base, false);
+  }
+}
+
+void String::assignNumber(unsigned long long value, unsigned char base, bool negative) {
+  char buf[8 * sizeof(unsigned long long) + 2];
+  const char *digits = toBase(buf, value, base, negative);
+  assign(digits, strlen(digits));
+}
+
+String::String(unsigned char value, unsigned char base) { assignNumber((unsigned long long)value, base, false); }
+String::String(int value, unsigned char base) { assignNumber((long long)value, base); }
+String::String(unsigned int value, unsigned char base) { assignNumber((unsigned long long)value, base, false); }
+String::String(long value, unsigned char base) { assignNumber((long long)value, base); }
+String::String(unsigned long value, unsigned char base) { assignNumber((unsigned long long)value, base, false); }
+String::String(float value, unsigned int decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned int decimalPlaces) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+  assign(buf, strlen(buf));
+}
+
+String::String(String &&s) { *this = std::move(s); }
+
+String &String::operator=(const String &rhs) {
+  if (this != &rhs) {
+    assign(rhs.c_str(), rhs._len);
+  }
+  return *this;
+}
+
+String &String::operator=(String &&rhs) {
+  if (this == &rhs) {
+    return *this;
+  }
+  if (!rhs._heap) {
+    assign(rhs._sso, rhs._len);
+    return *this;
+  }
+  delete[] _heap;
+  _heap = rhs._heap;
+  _len = rhs._len;
+  _capacity = rhs._capacity;
+  rhs._heap = nullptr;
+  rhs._len = 0;
+  rhs._capacity = SSO_SIZE;
+  rhs._sso[0] = '\0';
+  return *this;
+}
+
+void String::reserve(unsigned int capacity) {
+  if (capacity <= _capacity) {
+    return;
+  }
+  char *buf = new char[capacity + 1];
+  memcpy(buf, c_str(), _len + 1);
+  delete[] _heap;
+  _heap = buf;
+  _capacity = capacity;
+}
+
+void String::assign(const char *s, unsigned int len) {
+  reserve(len);
+  char *buf = _heap ? _heap : _sso;
+  memmove(buf, s, len);
+  buf[len] = '\0';
+  _len = len;
+}
+
+bool String::append(const char *s, unsigned int len) {
+  reserve(_len + len);
+  char *buf = _heap ? _heap : _sso;
+  memmove(buf + _len, s, len);
+  _len += len;
+  buf[_len] = '\0';
+  return true;
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+  if (fromIndex >= _len) {
+    return -1;
+  }
+  const char *found = strchr(c_str() + fromIndex, ch);
+  return found ? (int)(found - c_str()) : -1;
+}
+
+String String::substring(unsigned int beginIndex) const {
+  return substring(beginIndex, length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) {
+    std::swap(beginIndex, endIndex);
+  }
+  if (beginIndex >= _len) {
+    return String();
+  }
+  if (endIndex > _len) {
+    endIndex = _len;
+  }
+  String s;
+  s.assign(c_str() + beginIndex, endIndex - beginIndex);
+  return s;
+}
+
+long String::toInt() const { return atol(c_str()); }
+float String::toFloat() const { return atof(c_str()); }
+
+String operator+(const String &lhs, const String &rhs) {
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+String operator+(const String &lhs, const char *rhs) {
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+String operator+(const char *lhs, const String &rhs) {
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+String operator+(const String &lhs, char rhs) {
+  String s(lhs);
+  s += rhs;
+  return s;
+}
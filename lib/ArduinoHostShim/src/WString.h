@@ -0,0 +1,82 @@
+/*
+  WString.h - Arduino String. Like the ESP32 core it keeps up to 11
+  characters inline and heap-allocates anything longer, so host allocation
+  counts match the device.
+*/
+#ifndef WString_h
+#define WString_h
+
+#include <stddef.h>
+#include <string.h>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class String {
+public:
+  String(const char *cstr = "") { assign(cstr, cstr ? strlen(cstr) : 0); }
+  String(const __FlashStringHelper *str) : String(reinterpret_cast<const char *>(str)) {}
+  String(const String &s) { assign(s.c_str(), s._len); }
+  String(String &&s);
+  explicit String(char c) { assign(&c, 1); }
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned int decimalPlaces = 2);
+  explicit String(double value, unsigned int decimalPlaces = 2);
+
+  ~String() { delete[] _heap; }
+
+  String &operator=(const String &rhs);
+  String &operator=(String &&rhs);
+  String &operator=(const char *cstr) { assign(cstr, cstr ? strlen(cstr) : 0); return *this; }
+
+  const char *c_str() const { return _heap ? _heap : _sso; }
+  unsigned int length() const { return _len; }
+  bool isEmpty() const { return _len == 0; }
+  char operator[](unsigned int index) const { return index < _len ? c_str()[index] : 0; }
+  char charAt(unsigned int index) const { return (*this)[index]; }
+
+  bool concat(const String &s) { return append(s.c_str(), s._len); }
+  bool concat(const char *cstr) { return cstr ? append(cstr, strlen(cstr)) : true; }
+  bool concat(char c) { return append(&c, 1); }
+
+  String &operator+=(const String &rhs) { concat(rhs); return *this; }
+  String &operator+=(const char *cstr) { concat(cstr); return *this; }
+  String &operator+=(char c) { concat(c); return *this; }
+
+  bool equals(const String &s) const { return _len == s._len && memcmp(c_str(), s.c_str(), _len) == 0; }
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator==(const char *cstr) const { return strcmp(c_str(), cstr ? cstr : "") == 0; }
+  bool operator!=(const char *cstr) const { return !(*this == cstr); }
+
+  int indexOf(char ch, unsigned int fromIndex = 0) const;
+  String substring(unsigned int beginIndex) const;
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+  long toInt() const;
+  float toFloat() const;
+
+private:
+  static const unsigned int SSO_SIZE = 11;
+
+  char _sso[SSO_SIZE + 1] = {0};
+  char *_heap = nullptr;
+  unsigned int _len = 0;
+  unsigned int _capacity = SSO_SIZE;
+
+  void assign(const char *s, unsigned int len);
+  void assignNumber(long long value, unsigned char base);
+  void assignNumber(unsigned long long value, unsigned char base, bool negative);
+  bool append(const char *s, unsigned int len);
+  void reserve(unsigned int capacity);
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+String operator+(const String &lhs, char rhs);
+
+#endif
@@ -0,0 +1,47 @@
+/*
+  WiFi.cpp - simulated station: connects a fixed time after begin(), or
+  after the access point comes up if that is later.
+*/
+#include "WiFi.h"
+#include "HostSim.h"
+
+WiFiClass WiFi;
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase) {
+  (void)ssid;
+  (void)passphrase;
+  _started = true;
+  _beganAt = sim::elapsedMicros();
+  return status();
+}
+
+bool WiFiClass::disconnect(bool wifioff) {
+  (void)wifioff;
+  _started = false;
+  return true;
+}
+
+wl_status_t WiFiClass::status() {
+  long association = sim::wifiAssociationMillis();
+  if (!_started || association < 0) {
+    return WL_DISCONNECTED;
+  }
+  uint64_t from = std::max(_beganAt, (uint64_t)sim::accessPointUpMillis() * 1000);
+  if (sim::elapsedMicros() < from + (uint64_t)association * 1000) {
+    return WL_DISCONNECTED;
+  }
+  return WL_CONNECTED;
+}
+
+IPAddress WiFiClass::localIP() {
+  return status() == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+int WiFiClass::hostByName(const char *hostname, IPAddress &result) {
+  uint32_t address;
+  if (!sim::lookup(hostname, address)) {
+    return 0;
+  }
+  result = IPAddress(address);
+  return 1;
+}
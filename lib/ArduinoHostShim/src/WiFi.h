@@ -0,0 +1,39 @@
+/*
+  WiFi.h - station-mode Wi-Fi with a simulated association delay
+  (see sim::setWiFiAssociationMillis).
+*/
+#ifndef WiFi_h
+#define WiFi_h
+
+#include "Arduino.h"
+
+typedef enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+  wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+  bool disconnect(bool wifioff = false);
+  wl_status_t status();
+  bool isConnected() { return status() == WL_CONNECTED; }
+  IPAddress localIP();
+  int hostByName(const char *hostname, IPAddress &result);
+
+private:
+  bool _started = false;
+  uint64_t _beganAt = 0;
+};
+
+extern WiFiClass WiFi;
+
+#include "WiFiUdp.h"
+
+#endif
@@ -0,0 +1,155 @@
+/*
+  WiFiUdp.cpp - host socket implementation of the Arduino UDP API.
+*/
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "WiFiUdp.h"
+#include "HostSim.h"
+
+WiFiUDP::~WiFiUDP() { stop(); }
+
+bool WiFiUDP::ensureSocket() {
+  if (_fd >= 0) {
+    return true;
+  }
+  _fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (_fd < 0) {
+    return false;
+  }
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+  int on = 1;
+  setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)); // the kernel notes when each datagram arrived
+  return true;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+  stop();
+  if (!ensureSocket()) {
+    return 0;
+  }
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port < 1024 ? 0 : port); // privileged ports are stood in for, see sim::boundPort()
+  socklen_t len = sizeof(addr);
+  if (bind(_fd, (struct sockaddr *)&addr, len) != 0 || getsockname(_fd, (struct sockaddr *)&addr, &len) != 0) {
+    stop();
+    return 0;
+  }
+  if (port < 1024) {
+    sim::setBoundPort(port, ntohs(addr.sin_port));
+  }
+  return 1;
+}
+
+void WiFiUDP::stop() {
+  if (_fd >= 0) {
+    close(_fd);
+    _fd = -1;
+  }
+  _rxLength = _rxPos = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+  if (!ensureSocket() || !sim::resolveAddress((uint32_t)ip, port, _txAddress, _txPort)) {
+    return 0;
+  }
+  _txLength = 0;
+  return 1;
+}
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+  if (!ensureSocket() || !sim::resolve(host, port, _txAddress, _txPort)) {
+    return 0;
+  }
+  _txLength = 0;
+  return 1;
+}
+
+int WiFiUDP::endPacket() {
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = _txAddress;
+  addr.sin_port = htons(_txPort);
+  ssize_t sent = sendto(_fd, _txBuffer, _txLength, 0, (struct sockaddr *)&addr, sizeof(addr));
+  _txLength = 0;
+  sim::pump(); // in-process responders timestamp the datagram when it was sent, not at the next delay()
+  return sent >= 0 ? 1 : 0;
+}
+
+size_t WiFiUDP::write(uint8_t c) { return write(&c, 1); }
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+  size_t room = BUFFER_SIZE - _txLength;
+  if (size > room) {
+    size = room;
+  }
+  memcpy(_txBuffer + _txLength, buffer, size);
+  _txLength += size;
+  return size;
+}
+
+int WiFiUDP::parsePacket() {
+  sim::pump();
+  _rxLength = _rxPos = 0;
+  _rxArrival = 0;
+  if (_fd < 0) {
+    return 0;
+  }
+  struct sockaddr_in addr = {};
+  struct iovec data = {_rxBuffer, BUFFER_SIZE};
+  char control[CMSG_SPACE(sizeof(struct timespec))];
+  struct msghdr message = {};
+  message.msg_name = &addr;
+  message.msg_namelen = sizeof(addr);
+  message.msg_iov = &data;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  ssize_t len = recvmsg(_fd, &message, 0);
+  if (len <= 0) {
+    return 0;
+  }
+  for (struct cmsghdr *c = CMSG_FIRSTHDR(&message); c; c = CMSG_NXTHDR(&message, c)) {
+    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec arrived;
+      memcpy(&arrived, CMSG_DATA(c), sizeof(arrived));
+      _rxArrival = sim::deviceMicrosAtHostTime(arrived);
+    }
+  }
+  _rxLength = len;
+  _remoteIP = IPAddress((uint32_t)addr.sin_addr.s_addr);
+  _remotePort = ntohs(addr.sin_port);
+  return len;
+}
+
+int WiFiUDP::available() { return _rxLength - _rxPos; }
+
+int WiFiUDP::read() {
+  return _rxPos < _rxLength ? _rxBuffer[_rxPos++] : -1;
+}
+
+int WiFiUDP::read(unsigned char *buffer, size_t len) {
+  size_t n = std::min(len, _rxLength - _rxPos);
+  memcpy(buffer, _rxBuffer + _rxPos, n);
+  _rxPos += n;
+  return n;
+}
+
+int WiFiUDP::read(char *buffer, size_t len) {
+  return read((unsigned char *)buffer, len);
+}
+
+int WiFiUDP::peek() {
+  return _rxPos < _rxLength ? _rxBuffer[_rxPos] : -1;
+}
+
+void WiFiUDP::flush() { _rxLength = _rxPos = 0; }
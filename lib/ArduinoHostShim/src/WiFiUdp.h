@@ -0,0 +1,63 @@
+/*
+  WiFiUdp.h - UDP over a non-blocking host socket. Destinations go through
+  sim::resolve(), so traffic can be diverted to in-process fake servers.
+*/
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+#include "Udp.h"
+
+class WiFiUDP : public UDP {
+public:
+  WiFiUDP() {}
+  ~WiFiUDP();
+
+  uint8_t begin(uint16_t port) override;
+  void stop() override;
+
+  int beginPacket(IPAddress ip, uint16_t port) override;
+  int beginPacket(const char *host, uint16_t port) override;
+  int endPacket() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  int parsePacket() override;
+  int available() override;
+  int read() override;
+  int read(unsigned char *buffer, size_t len) override;
+  int read(char *buffer, size_t len) override;
+  int peek() override;
+  void flush() override;
+
+  IPAddress remoteIP() override { return _remoteIP; }
+  uint16_t remotePort() override { return _remotePort; }
+
+  /**
+   * esp_timer_get_time() when the datagram parsePacket() returned reached
+   * the socket, from the kernel's receive timestamp (SO_TIMESTAMPNS); 0 if
+   * there is none. Not in the ESP32 core's WiFiUDP.
+   */
+  uint64_t arrivalMicros() const { return _rxArrival; }
+
+private:
+  static const size_t BUFFER_SIZE = 1460;
+
+  int _fd = -1;
+  uint32_t _txAddress = 0;
+  uint16_t _txPort = 0;
+  size_t _txLength = 0;
+  uint8_t _txBuffer[BUFFER_SIZE];
+
+  size_t _rxLength = 0;
+  size_t _rxPos = 0;
+  uint8_t _rxBuffer[BUFFER_SIZE];
+  uint64_t _rxArrival = 0;
+
+  IPAddress _remoteIP;
+  uint16_t _remotePort = 0;
+
+  bool ensureSocket();
+};
+
+#endif
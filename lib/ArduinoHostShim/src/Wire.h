@@ -0,0 +1,33 @@
+/*
+  Wire.h - empty I2C bus; nothing on the simulated board answers.
+*/
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+public:
+  bool begin() { return true; }
+  bool end() { return true; }
+  void setClock(uint32_t frequency) { (void)frequency; }
+  void beginTransmission(uint8_t address) { (void)address; }
+  uint8_t endTransmission(bool sendStop = true) { (void)sendStop; return 2; }
+  size_t requestFrom(uint8_t address, size_t size, bool sendStop = true) {
+    (void)address;
+    (void)size;
+    (void)sendStop;
+    return 0;
+  }
+
+  size_t write(uint8_t data) override { (void)data; return 0; }
+  size_t write(const uint8_t *data, size_t size) override { (void)data; (void)size; return 0; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+};
+
+extern TwoWire Wire;
+
+#endif
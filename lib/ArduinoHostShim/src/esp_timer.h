@@ -0,0 +1,12 @@
+/*
+  esp_timer.h - the ESP-IDF high-resolution timer: the 64-bit count of
+  device microseconds since boot that millis()/micros() are cut down from.
+*/
+#ifndef esp_timer_h
+#define esp_timer_h
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
+
+#endif
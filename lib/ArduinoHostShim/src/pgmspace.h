@@ -0,0 +1,18 @@
+/*
+  pgmspace.h - flash access macros; on the host flash is plain memory.
+*/
+#ifndef pgmspace_h
+#define pgmspace_h
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr)  (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)  (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_float(addr) (*(const float *)(addr))
+#define pgm_read_ptr(addr)   (*(void *const *)(addr))
+
+#endif
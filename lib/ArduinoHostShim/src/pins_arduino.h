@@ -0,0 +1 @@
+/* pins_arduino.h - no board variant on the host. */
@@ -0,0 +1 @@
+/* wiring_private.h - nothing private to wire up on the host. */
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+   Proleptic Gregorian calendar arithmetic on day counts since 1970-01-01,
+   after Howard Hinnant's days_from_civil() and civil_from_days(). Years
+   are counted in full (2024, not 124) and months from 1; day counts are
+   64-bit, so dates past 2038 and 2106 come out right.
+
+   Shared by the clock face calendar, the time zone rules and NTPClient's
+   leap second scheduling; header only, nothing to link.
+*/
+namespace CivilDate {
+
+inline bool isLeapYear(long year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/**
+   @param month 1-12
+*/
+inline uint8_t daysInMonth(long year, uint8_t month) {
+  static const uint8_t LENGTHS[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  return month == 2 && isLeapYear(year) ? 29 : LENGTHS[month - 1];
+}
+
+/**
+   @return days since 1970-01-01 of a date, negative before it
+*/
+inline int64_t daysFromCivil(long year, uint8_t month, uint8_t day) {
+  year -= month <= 2;
+  long era = (year >= 0 ? year : year - 399) / 400;
+  long yearOfEra = year - era * 400;
+  long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1; // In years that start in March
+  long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return (int64_t)era * 146097 + dayOfEra - 719468;
+}
+
+/**
+   Date of a day count since 1970-01-01. @return the day of the year,
+   0 for January 1
+*/
+inline int civilFromDays(int64_t days, long& year, uint8_t& month, uint8_t& day) {
+  days += 719468; // From 0000-03-01, so the leap day ends the year
+  int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  long dayOfEra = (long)(days - era * 146097);
+  long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  long monthIndex = (5 * dayOfYear + 2) / 153; // 0 is March
+  year = (long)(yearOfEra + era * 400) + (monthIndex >= 10);
+  month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+  day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+  // March 1 is day 59 of a common year, day 60 of a leap year
+  return monthIndex < 10 ? dayOfYear + 59 + isLeapYear(year) : dayOfYear - 306;
+}
+
+} // namespace CivilDate
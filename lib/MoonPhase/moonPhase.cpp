@@ -0,0 +1,218 @@
+#include <inttypes.h>
+
+#include "moonPhase.h"
+
+static double _sun_position(const double &j)
+{
+  double n, x, e, l, dl, v;
+  int32_t i;
+  n = 360 / 365.2422 * j;
+  i = n / 360;
+  n = n - i * 360.0;
+  x = n - 3.762863;
+  x += (x < 0) ? 360 : 0;
+  x *= DEG_TO_RAD;
+  e = x;
+  do {
+    dl = e - .016718 * sin(e) - x;
+    e = e - dl / (1 - .016718 * cos(e));
+  } while (fabs(dl) >= 1e-12);
+  v = 360 / PI * atan(1.01686011182 * tan(e / 2));
+  l = v + 282.596403;
+  i = l / 360;
+  l = l - i * 360.0;
+  return l;
+}
+
+static double _moon_position(const double &j, const double &ls)
+{
+  double ms, l, mm, ev, sms, ae, ec;
+  int32_t i;
+  ms = 0.985647332099 * j - 3.762863;
+  ms += (ms < 0) ? 360.0 : 0;
+  l = 13.176396 * j + 64.975464;
+  i = l / 360;
+  l = l - i * 360.0;
+  l += (l < 0) ? 360 : 0;
+  mm = l - 0.1114041 * j - 349.383063;
+  i = mm / 360;
+  mm -= i * 360.0;
+  ev = 1.2739 * sin((2 * (l - ls) - mm) * DEG_TO_RAD);
+  sms = sin(ms * DEG_TO_RAD);
+  ae = 0.1858 * sms;
+  mm += ev - ae - 0.37 * sms;
+  ec = 6.2886 * sin(mm * DEG_TO_RAD);
+  l += ev + ec - ae + 0.214 * sin(2 * mm * DEG_TO_RAD);
+  l = 0.6583 * sin(2 * (l - ls) * DEG_TO_RAD) + l;
+  return l;
+}
+
+static double _days_since_1980(const int64_t t)
+{
+  // Julian date - 2444238.5 (1980-01-01 00:00 UTC)
+  return t / 86400.0 - 3651.0;
+}
+
+moonData_t moonPhase::getPhase(const int64_t t)
+{
+/*
+  Calculates the phase of the moon at the given epoch.
+  returns the moon phase angle as an int (0-360)
+  returns the moon percentage that is lit as a real number (0-1)
+*/
+  const double j {_days_since_1980(t)};
+  const double ls {_sun_position(j)};
+  const double lm {_moon_position(j, ls)};
+  double angle = lm - ls;
+  angle += (angle < 0) ? 360 : 0;
+  const moonData_t returnValue
+  {
+    (int32_t)angle,
+    (1.0 - cos((lm - ls) * DEG_TO_RAD)) / 2
+  };
+  return returnValue;
+}
+
+static const double _SYNODIC_MONTH = 29.530588853;          // mean, in days
+static const double _MEAN_RATE = 360.0 / _SYNODIC_MONTH;    // degrees per day
+
+/*
+  Phase angle at day j in degrees, not reduced to 0-360.
+*/
+static double _phase_angle(const double &j)
+{
+  const double ls {_sun_position(j)};
+  return _moon_position(j, ls) - ls;
+}
+
+/*
+  Secant search for the first instant after t at which phase(j) reaches the
+  target angle. phase is the angle at day j, in degrees, reduced or not.
+*/
+template <typename Phase>
+static int64_t _next_phase(const int64_t t, const double angle, Phase phase)
+{
+  const double start {_days_since_1980(t)};
+
+  // Signed distance in degrees (-180..180] from the phase angle at day j to
+  // the target angle.
+  auto error = [&](const double j) { return remainder(phase(j) - angle, 360.0); };
+
+  // First guess from the mean synodic rate, always strictly ahead of t
+  double ahead = -error(start);
+  if (ahead <= 0) {
+    ahead += 360.0;
+  }
+  double j = start + ahead / _MEAN_RATE;
+  double f = error(j);
+
+  // The true rate swings about +-20% around the mean, so one mean-rate step
+  // followed by secant steps converges in a handful of evaluations.
+  double jPrev = j;
+  double fPrev = f;
+  j -= f / _MEAN_RATE;
+  for (int i = 0; i < 10; i++) {
+    f = error(j);
+    double rate = (f - fPrev) / (j - jPrev);
+    if (!(rate > 0.5 * _MEAN_RATE && rate < 2 * _MEAN_RATE)) {
+      rate = _MEAN_RATE;
+    }
+    const double step = f / rate;
+    jPrev = j;
+    fPrev = f;
+    j -= step;
+    if (fabs(step) < 0.5 / 86400) {
+      break;
+    }
+  }
+  if (j <= start) {
+    // Solved back onto t itself (t sits on the phase); take the next cycle
+    return _next_phase(t + 86400, angle, phase);
+  }
+  return (int64_t)((j + 3651.0) * 86400.0 + 0.5);
+}
+
+int64_t moonPhase::getNextPhase(const int64_t t, const double angle)
+{
+  return _next_phase(t, angle, _phase_angle);
+}
+
+/*
+  Phase angle at day j from the table, or worked out if the four samples
+  around j are not all in it.
+*/
+double moonEphemeris::_angle(const double j) const
+{
+  const double x {j * SAMPLES_PER_DAY - _first};
+  const int32_t i = floor(x);
+  if (!_filled || i < 1 || i + 2 >= SAMPLES) {
+    return _phase_angle(j);
+  }
+  // Lagrange cubic through samples i-1..i+2, at u from sample i. The
+  // deviation wraps at +-180 degrees; unwrap the outer ones against i.
+  const double u {x - i};
+  const double y1 = _deviation[i];
+  const double y0 = y1 + remainder(_deviation[i - 1] - y1, 360.0);
+  const double y2 = y1 + remainder(_deviation[i + 1] - y1, 360.0);
+  const double y3 = y1 + remainder(_deviation[i + 2] - y1, 360.0);
+  const double deviation = u * (u - 1) * ((u + 1) * y3 - (u - 2) * y0) / 6
+                         + (u + 1) * (u - 2) * ((u - 1) * y1 - u * y2) / 2;
+  return _MEAN_RATE * j + deviation;
+}
+
+/*
+  Make sure the table interpolates every day from `from` to `to`. Samples
+  the old window shares with the new one are kept.
+*/
+void moonEphemeris::_cover(const double from, const double to)
+{
+  const int32_t first = (int32_t)floor(from * SAMPLES_PER_DAY) - 1;
+  const int32_t last = (int32_t)ceil(to * SAMPLES_PER_DAY) + 2;
+  if (_filled && first >= _first && last < _first + SAMPLES) {
+    return;
+  }
+  if (last - first >= SAMPLES) {
+    return; // Does not fit; _angle() works these out
+  }
+
+  int32_t keepFrom = 0;
+  int32_t keepTo = 0;
+  const int32_t shift = first - _first;
+  if (_filled && shift < SAMPLES && shift > -SAMPLES) {
+    keepFrom = shift < 0 ? -shift : 0;
+    keepTo = shift > 0 ? SAMPLES - shift : SAMPLES;
+    memmove(_deviation + keepFrom, _deviation + keepFrom + shift, (keepTo - keepFrom) * sizeof(float));
+  }
+  for (int32_t k = 0; k < SAMPLES; k++) {
+    if (k >= keepFrom && k < keepTo) {
+      continue;
+    }
+    const double j {(double)(first + k) / SAMPLES_PER_DAY};
+    _deviation[k] = remainder(_phase_angle(j) - _MEAN_RATE * j, 360.0);
+  }
+  _first = first;
+  _filled = true;
+}
+
+moonData_t moonEphemeris::getPhase(const int64_t t)
+{
+  const double j {_days_since_1980(t)};
+  _cover(j, j);
+  double angle = fmod(_angle(j), 360.0);
+  angle += (angle < 0) ? 360 : 0;
+  const moonData_t returnValue
+  {
+    (int32_t)angle,
+    (1.0 - cos(angle * DEG_TO_RAD)) / 2
+  };
+  return returnValue;
+}
+
+int64_t moonEphemeris::getNextPhase(const int64_t t, const double angle)
+{
+  // The phase comes round again within 29.9 days; the secant steps may
+  // look a little beyond
+  const double start {_days_since_1980(t)};
+  _cover(start, start + _SYNODIC_MONTH + 1.5);
+  return _next_phase(t, angle, [this](const double j) { return _angle(j); });
+}
@@ -0,0 +1,87 @@
+/*
+  MoonPhase.h - Library to get moon phase angle
+  and percentage illuminated. (as seen from Earth)
+  Created by Marcel Timmer, April 28, 2018.
+  Code adapted from http://www.voidware.com/phase.c
+  A big thanks to Hugh at voidware for granting permission.
+  Released under MIT license.
+*/
+#ifndef MoonPhase_h
+#define MoonPhase_h
+
+#include <Arduino.h>
+
+struct moonData_t
+{
+  int32_t angle;
+  double  percentLit;
+};
+
+class moonPhase
+{
+public:
+  /*
+    Times are 64-bit seconds since 1970 (UTC), so they go on past 2038
+    where a 32-bit time_t ends.
+  */
+  moonData_t getPhase(const int64_t t);
+
+  moonData_t getPhase()
+  {
+    return getPhase((int64_t)time(NULL));
+  }
+
+  /*
+    Returns the first instant after t at which the moon reaches the given
+    phase angle in degrees (0 = new, 90 = first quarter, 180 = full,
+    270 = last quarter), to within a second. Solved by secant iteration on
+    the phase angle; typically 4-5 evaluations of the ephemeris.
+  */
+  int64_t getNextPhase(const int64_t t, const double angle);
+
+  int64_t getNextNewMoon(const int64_t t)      { return getNextPhase(t, 0); }
+  int64_t getNextFirstQuarter(const int64_t t) { return getNextPhase(t, 90); }
+  int64_t getNextFullMoon(const int64_t t)     { return getNextPhase(t, 180); }
+  int64_t getNextLastQuarter(const int64_t t)  { return getNextPhase(t, 270); }
+};
+
+/*
+  Answers what moonPhase does from a table of the phase angle sampled every
+  six hours, instead of working out the sun's and moon's positions on each
+  call. Between samples the angle is a cubic through the four nearest,
+  within 2e-5 degrees (0.1 s of phase timing) of moonPhase. The table
+  spans 48 days and follows the queries: it is filled on first use and,
+  when a query falls outside it, moves there and computes only the samples
+  it does not have yet. A clock asking about now and the coming month
+  computes about four samples a day. Spans too long for the table, and
+  instants outside it, fall back to the full calculation.
+*/
+class moonEphemeris
+{
+public:
+  static const int32_t SAMPLES_PER_DAY = 4;
+  static const int32_t SAMPLES = 192;
+
+  moonData_t getPhase(const int64_t t);
+
+  moonData_t getPhase()
+  {
+    return getPhase((int64_t)time(NULL));
+  }
+
+  int64_t getNextPhase(const int64_t t, const double angle);
+
+  int64_t getNextNewMoon(const int64_t t)      { return getNextPhase(t, 0); }
+  int64_t getNextFirstQuarter(const int64_t t) { return getNextPhase(t, 90); }
+  int64_t getNextFullMoon(const int64_t t)     { return getNextPhase(t, 180); }
+  int64_t getNextLastQuarter(const int64_t t)  { return getNextPhase(t, 270); }
+
+private:
+  bool    _filled = false;
+  int32_t _first = 0;           // sample 0 is at day _first / SAMPLES_PER_DAY since 1980
+  float   _deviation[SAMPLES];  // phase angle minus the mean synodic motion, degrees (-180..180]
+
+  double _angle(const double j) const;
+  void   _cover(const double from, const double to);
+};
+#endif
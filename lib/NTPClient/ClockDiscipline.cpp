@@ -0,0 +1,146 @@
+#include "ClockDiscipline.h"
+
+void ClockDiscipline::reset() {
+  this->_set          = false;
+  this->_base         = 0;
+  this->_slew         = 0;
+  this->_drift        = 0;
+  this->_driftVariance = (double)DISCIPLINE_MAX_DRIFT * DISCIPLINE_MAX_DRIFT;
+  this->_minDelay     = LONG_MAX;
+  this->_lastNoise    = 0;
+  this->_poll         = DISCIPLINE_MIN_POLL;
+  this->_goodSamples  = 0;
+  this->_lastResidual = 0;
+  this->_jitter       = 0;
+  this->_pollReason   = NTP_POLL_KEPT;
+  this->_steps        = 0;
+}
+
+bool ClockDiscipline::isSet() const {
+  return this->_set;
+}
+
+int64_t ClockDiscipline::slewedAt(uint64_t elapsed) const {
+  int64_t limit = elapsed * DISCIPLINE_MAX_SLEW / 1000000;
+  if (this->_slew > limit) return limit;
+  if (this->_slew < -limit) return -limit;
+  return this->_slew;
+}
+
+uint64_t ClockDiscipline::timeAt(uint64_t elapsed) const {
+  return this->_base + elapsed
+       - (int64_t)(elapsed * this->_drift * 1e-6) // Frequency correction
+       + this->slewedAt(elapsed);                  // Phase correction
+}
+
+void ClockDiscipline::estimate(uint64_t elapsed, uint64_t time) {
+  this->_base += time - this->timeAt(elapsed);
+}
+
+void ClockDiscipline::sample(uint64_t elapsed, int64_t offset, long delay) {
+  uint64_t now = this->timeAt(elapsed);
+
+  // Queueing only ever adds delay, so the excess over the best round trip bounds the error of this sample
+  if (delay < this->_minDelay) this->_minDelay = delay;
+  int64_t noise = 1000 + (delay - this->_minDelay) / 2;
+
+  if (!this->_set || offset > DISCIPLINE_STEP_THRESHOLD || offset < -DISCIPLINE_STEP_THRESHOLD) {
+    // Too far off to slew in reasonable time: step, and sample again soon. With nothing to compare the round trip
+    // against, all of it may be asymmetry
+    this->_lastNoise    = 1000 + delay / 2;
+    this->_base         = now + offset;
+    this->_slew         = 0;
+    this->_poll         = DISCIPLINE_MIN_POLL;
+    this->_goodSamples  = 0;
+    this->_lastResidual = offset;
+    this->_jitter       = 0;
+    this->_pollReason   = NTP_POLL_STEP;
+    this->_set          = true;
+    this->_steps++;
+    return;
+  }
+
+  // Whatever the pending correction does not explain accumulated from the frequency error over `elapsed`
+  int64_t residual = offset - (this->_slew - this->slewedAt(elapsed));
+  double seconds = elapsed * 1e-6;
+  this->_driftVariance += DISCIPLINE_WANDER * seconds;
+  if (seconds >= 1) {
+    // The residual carries the error of the previous sample, which was slewed in, as well as this one's
+    double measured = -(double)residual / seconds;                       // ppm
+    double variance = sq((double)(noise + this->_lastNoise) / seconds); // ppm^2
+    double gain = this->_driftVariance / (this->_driftVariance + variance);
+    this->_drift += gain * measured;
+    this->_drift = constrain(this->_drift, (double)-DISCIPLINE_MAX_DRIFT, (double)DISCIPLINE_MAX_DRIFT);
+    this->_driftVariance *= 1 - gain;
+  }
+
+  this->_base         = now;
+  this->_slew         = offset;
+  this->_lastResidual = residual;
+  this->_lastNoise    = noise;
+  this->_jitter       = sqrt(sq((double)this->_jitter) + (sq((double)residual) - sq((double)this->_jitter)) / 4);
+
+  this->adjustPoll(residual, noise);
+}
+
+void ClockDiscipline::adjustPoll(int64_t residual, int64_t noise) {
+  uint8_t poll = this->_poll;
+  if (residual > 8 * noise || residual < -8 * noise) {
+    // Something moved, the clock or the network: look again soon
+    this->_pollReason  = NTP_POLL_DISTURBED;
+    this->_goodSamples = 0;
+    if (poll > DISCIPLINE_MIN_POLL) poll--;
+  } else if (this->_jitter > 4 * noise) {
+    this->_pollReason  = NTP_POLL_JITTER;
+    this->_goodSamples = 0;
+    if (poll > DISCIPLINE_MIN_POLL) poll--;
+  } else if (residual <= 2 * noise && residual >= -2 * noise && this->_jitter <= 2 * noise
+             && ++this->_goodSamples >= DISCIPLINE_POLL_STABLE) {
+    // The drift estimate holds: the clock can run longer on its own
+    this->_pollReason  = NTP_POLL_STABLE;
+    this->_goodSamples = 0;
+    if (poll < DISCIPLINE_MAX_POLL) poll++;
+  }
+  if (poll == this->_poll) this->_pollReason = NTP_POLL_KEPT;
+  this->_poll = poll;
+}
+
+unsigned long ClockDiscipline::pollInterval() const {
+  return 1000UL << this->_poll;
+}
+
+NTPPollReason ClockDiscipline::getPollReason() const {
+  return this->_pollReason;
+}
+
+void ClockDiscipline::restartPoll() {
+  this->_pollReason  = this->_poll > DISCIPLINE_MIN_POLL ? NTP_POLL_RESTART : NTP_POLL_KEPT;
+  this->_poll        = DISCIPLINE_MIN_POLL;
+  this->_goodSamples = 0;
+  this->_minDelay    = LONG_MAX;
+}
+
+double ClockDiscipline::getDriftPpm() const {
+  return this->_drift;
+}
+
+double ClockDiscipline::getDriftErrorPpm() const {
+  return sqrt(this->_driftVariance);
+}
+
+void ClockDiscipline::setDriftPpm(double drift, double error) {
+  this->_drift = constrain(drift, (double)-DISCIPLINE_MAX_DRIFT, (double)DISCIPLINE_MAX_DRIFT);
+  this->_driftVariance = constrain(sq(error), 0.01, (double)DISCIPLINE_MAX_DRIFT * DISCIPLINE_MAX_DRIFT);
+}
+
+int64_t ClockDiscipline::getLastResidual() const {
+  return this->_lastResidual;
+}
+
+int64_t ClockDiscipline::getJitter() const {
+  return this->_jitter;
+}
+
+unsigned long ClockDiscipline::getSteps() const {
+  return this->_steps;
+}
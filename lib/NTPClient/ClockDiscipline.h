@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Arduino.h"
+
+#include <limits.h>
+
+#define DISCIPLINE_STEP_THRESHOLD 128000  // In us, larger offsets are stepped instead of slewed
+#define DISCIPLINE_MAX_SLEW       500     // In ppm, rate at which offsets are slewed out
+#define DISCIPLINE_MAX_DRIFT      500     // In ppm, frequency error beyond this is not believed
+#define DISCIPLINE_MIN_POLL       6       // 2^6 = 64 s
+#define DISCIPLINE_MAX_POLL       10      // 2^10 = 1024 s
+#define DISCIPLINE_WANDER         1e-4    // In ppm^2/s, how fast the crystal frequency is assumed to wander
+#define DISCIPLINE_POLL_STABLE    3       // Calm samples in a row before the poll interval doubles
+
+/**
+ * Why the suggested poll interval last changed
+ */
+enum NTPPollReason : uint8_t {
+  NTP_POLL_KEPT,                        // Unchanged
+  NTP_POLL_STEP,                        // The clock was set or stepped: shortest interval
+  NTP_POLL_DISTURBED,                   // Residual far beyond the sample's noise: halved
+  NTP_POLL_JITTER,                      // Residuals keep spreading beyond the noise: halved
+  NTP_POLL_STABLE,                      // Residual and jitter within the noise for several samples: doubled
+  NTP_POLL_RESTART                      // restartPoll(), e.g. the network path changed: shortest interval
+};
+
+/**
+ * Disciplines a free-running local clock (monotonicMicros()) to NTP samples.
+ *
+ * Small offsets are slewed out at up to 500 ppm instead of being stepped, so the clock never jumps. What is left of
+ * an offset once the previous correction is accounted for is frequency error, which is folded into a drift
+ * estimate (FLL) weighted by how much the sample can be trusted: a long interval and a round trip close to the
+ * best one seen make for a precise frequency measurement.
+ *
+ * The suggested poll interval adapts to how well the clock keeps time. While the residual and its RMS over recent
+ * samples (jitter) stay within twice the noise of the samples, it doubles every DISCIPLINE_POLL_STABLE samples, from
+ * 64 s up to 1024 s. A residual beyond 8 times the noise, or jitter beyond 4 times, halves it; a step drops it back
+ * to 64 s.
+ */
+class ClockDiscipline {
+  private:
+    bool          _set            = false;
+    uint64_t      _base           = 0;      // In us since 1970, clock reading at the last sample
+    int64_t       _slew           = 0;      // In us, correction still to be slewed in from the last sample
+    double        _drift          = 0;      // In ppm, how fast the local clock runs
+    double        _driftVariance  = (double)DISCIPLINE_MAX_DRIFT * DISCIPLINE_MAX_DRIFT; // In ppm^2, uncertainty of _drift
+    long          _minDelay       = LONG_MAX; // In us, best round trip seen
+    int64_t       _lastNoise      = 0;      // In us, error bound of the last sample
+    uint8_t       _poll           = DISCIPLINE_MIN_POLL;
+    uint8_t       _goodSamples    = 0;
+    int64_t       _lastResidual   = 0;      // In us
+    int64_t       _jitter         = 0;      // In us, RMS of the recent residuals
+    NTPPollReason _pollReason     = NTP_POLL_KEPT;
+    unsigned long _steps          = 0;
+
+    int64_t       slewedAt(uint64_t elapsed) const;
+    void          adjustPoll(int64_t residual, int64_t noise);
+
+  public:
+    /**
+     * Forget everything, e.g. after the time source changed
+     */
+    void reset();
+
+    /**
+     * @return true once the first sample has set the clock
+     */
+    bool isSet() const;
+
+    /**
+     * @param elapsed local microseconds since the last sample
+     * @return disciplined time in microseconds since Jan. 1, 1970
+     */
+    uint64_t timeAt(uint64_t elapsed) const;
+
+    /**
+     * Make timeAt(elapsed) read time without counting as a measurement: the first sample still steps the clock.
+     * For a rough time to go on with before there is any, e.g. one saved before a reboot
+     */
+    void estimate(uint64_t elapsed, uint64_t time);
+
+    /**
+     * Feed a measurement; the clock is re-anchored at it, so later calls to timeAt() count from here.
+     *
+     * @param elapsed local microseconds since the last sample
+     * @param offset  server time minus timeAt(elapsed), in microseconds
+     * @param delay   round-trip delay of the measurement, in microseconds
+     */
+    void sample(uint64_t elapsed, int64_t offset, long delay);
+
+    /**
+     * @return suggested time until the next sample, in ms
+     */
+    unsigned long pollInterval() const;
+
+    /**
+     * @return how the last sample or restartPoll() changed pollInterval()
+     */
+    NTPPollReason getPollReason() const;
+
+    /**
+     * Go back to the shortest poll interval and forget the best round trip, e.g. after the network reconnected: the
+     * path to the servers, and with it the delay and asymmetry, may have changed. The time and drift are kept.
+     */
+    void restartPoll();
+
+    /**
+     * @return estimated frequency error of the local clock, positive when it runs fast, in ppm
+     */
+    double getDriftPpm() const;
+
+    /**
+     * @return standard error of getDriftPpm(), in ppm
+     */
+    double getDriftErrorPpm() const;
+
+    /**
+     * Seed the drift estimate, e.g. from a value saved before a reboot along with its getDriftErrorPpm()
+     */
+    void setDriftPpm(double drift, double error = 1);
+
+    /**
+     * @return offset of the last sample minus the correction that was still pending, in microseconds
+     */
+    int64_t getLastResidual() const;
+
+    /**
+     * @return RMS of the recent residuals, in microseconds
+     */
+    int64_t getJitter() const;
+
+    /**
+     * @return number of times the clock was stepped, including the initial set
+     */
+    unsigned long getSteps() const;
+};
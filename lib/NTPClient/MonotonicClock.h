@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Arduino.h"
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(SIM_HOST)
+#include <esp_timer.h>
+#endif
+
+/**
+ * Microseconds since boot on a 64-bit count that does not wrap in the lifetime of the device. millis() and micros()
+ * are 32 bits wide and wrap after 49.7 days and 71.6 minutes, so an interval measured with them is only right while
+ * it is shorter than that.
+ *
+ * On the ESP32 this is esp_timer_get_time(), the counter millis() and micros() are cut down from. Other boards
+ * extend micros() in software, which catches every wrap as long as it is read at least once every 71 minutes.
+ */
+inline uint64_t monotonicMicros() {
+#if defined(ARDUINO_ARCH_ESP32) || defined(SIM_HOST)
+  return (uint64_t)esp_timer_get_time();
+#else
+  static uint32_t last  = 0;
+  static uint32_t wraps = 0;
+  uint32_t now = micros();
+  if (now < last) wraps++;
+  last = now;
+  return (uint64_t)wraps << 32 | now;
+#endif
+}
@@ -0,0 +1,754 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2015 by Fabrice Weinberg
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "NTPClient.h"
+
+#include <CivilDate.h>
+
+NTPClient::NTPClient(UDP& udp) {
+  this->_udp            = &udp;
+}
+
+NTPClient::NTPClient(UDP& udp, long timeOffset) {
+  this->_udp            = &udp;
+  this->_timeOffset     = timeOffset;
+}
+
+NTPClient::NTPClient(UDP& udp, const char* poolServerName) {
+  this->_udp            = &udp;
+  this->_poolServerName = poolServerName;
+}
+
+NTPClient::NTPClient(UDP& udp, IPAddress poolServerIP) {
+  this->_udp            = &udp;
+  this->_poolServerIP   = poolServerIP;
+  this->_poolServerName = NULL;
+}
+
+NTPClient::NTPClient(UDP& udp, const char* poolServerName, long timeOffset) {
+  this->_udp            = &udp;
+  this->_timeOffset     = timeOffset;
+  this->_poolServerName = poolServerName;
+}
+
+NTPClient::NTPClient(UDP& udp, IPAddress poolServerIP, long timeOffset){
+  this->_udp            = &udp;
+  this->_timeOffset     = timeOffset;
+  this->_poolServerIP   = poolServerIP;
+  this->_poolServerName = NULL;
+}
+
+NTPClient::NTPClient(UDP& udp, const char* poolServerName, long timeOffset, unsigned long updateInterval) {
+  this->_udp            = &udp;
+  this->_timeOffset     = timeOffset;
+  this->_poolServerName = poolServerName;
+  this->_updateInterval = updateInterval;
+  this->_adaptiveInterval = false;
+}
+
+NTPClient::NTPClient(UDP& udp, IPAddress poolServerIP, long timeOffset, unsigned long updateInterval) {
+  this->_udp            = &udp;
+  this->_timeOffset     = timeOffset;
+  this->_poolServerIP   = poolServerIP;
+  this->_poolServerName = NULL;
+  this->_updateInterval = updateInterval;
+  this->_adaptiveInterval = false;
+}
+
+void NTPClient::begin() {
+  this->begin(NTP_DEFAULT_LOCAL_PORT);
+}
+
+void NTPClient::begin(unsigned int port) {
+  this->_port = port;
+
+  this->_udp->begin(this->_port);
+
+  this->_udpSetup = true;
+}
+
+bool NTPClient::forceUpdate() {
+  if (!this->beginUpdate()) return false;
+
+  // Wait till data is there or timeout...
+  do {
+    delay ( 1 ); // the arrival time is only as good as this
+    if (this->poll()) return true;
+  } while (this->_updatePending);
+
+  return false;
+}
+
+bool NTPClient::beginUpdate() {
+  #ifdef DEBUG_NTPClient
+    Serial.println("Update from NTP Server");
+  #endif
+
+  this->_updatePending = false;
+  this->refreshPoolPeer();
+  this->foldLeap();
+
+  // flush any existing packets
+  while(this->_udp->parsePacket() != 0)
+    this->_udp->flush();
+
+  // Every server gets its first request right away; the rest of each burst follows its replies
+  bool sent = false;
+  for (uint8_t i = 0; i < this->_serverCount; i++) {
+    NTPPeer& peer = this->_peers[i];
+    peer.sent     = 0;
+    peer.received = 0;
+    peer.waiting  = false;
+    if (this->isResolveDue(peer, monotonicMicros())) this->resolve(peer);
+    if (peer.kiss == NTPPacket::code("DENY") || peer.kiss == NTPPacket::code("RSTR")) continue;
+    this->nextRequest(peer);
+    sent |= peer.waiting;
+  }
+  if (!sent) return false;
+  this->_updatePending = true;
+
+  return true;
+}
+
+bool NTPClient::poll() {
+  if (!this->_updatePending) return false;
+
+  int cb = this->_udp->parsePacket();
+  // T4, the arrival time on our clock, is read before anything else; the network stack may know it better
+  uint64_t received = monotonicMicros();
+  if (cb >= NTP_PACKET_SIZE) {
+    uint64_t arrived = this->_arrivalTime ? this->_arrivalTime() : 0;
+    if (arrived == 0 || arrived > received) arrived = received;
+    this->_udp->read(this->_packetBuffer, NTP_PACKET_SIZE);
+    this->_udp->flush();
+
+    // A reply echoes our transmit timestamp as its originate timestamp, which tells the servers apart; anything
+    // that matches no outstanding request is stale, a duplicate or not ours
+    NTPPacket reply(this->_packetBuffer);
+    bool matched = false;
+    for (uint8_t i = 0; i < this->_serverCount && !matched; i++) {
+      NTPPeer& peer = this->_peers[i];
+      if (!peer.waiting || !reply.isReplyTo(peer.requestTimestamp)) continue;
+      matched = true;
+      peer.waiting = false;
+
+      NTPReplyStatus status = reply.checkReply();
+      if (status == NTP_REPLY_KISS) {
+        // The server wants us gone (DENY, RSTR) or slower (RATE): no more requests this update, and none at all
+        // to this address after a DENY or RSTR
+        peer.kiss = reply.referenceId();
+        peer.sent = this->_burstSize;
+      }
+
+      // Offset and round-trip delay from the four timestamps (RFC 5905): T1 request sent, T2 request received,
+      // T3 reply sent, T4 reply received; T1 and T4 are on our clock, T2 and T3 on the server's. The clock is
+      // left alone until the update is over, so all samples are measured against the same one
+      int64_t t1 = peer.requestTimestamp;
+      int64_t t2 = reply.receiveMicros();
+      int64_t t3 = reply.transmitMicros();
+      int64_t t4 = this->steppedMicrosAt(arrived);
+      int64_t delay = (t4 - t1) - (t3 - t2);
+      // T1 and T4 step at a leap second like the server's clock: a sample taken across it is a second off, which
+      // shows as the round trip on our clock disagreeing with the local time that passed
+      int64_t leapt = (t4 - t1) - (int64_t)(arrived - peer.requestSent);
+      bool straddled = this->_leap != NTP_LEAP_NONE && (leapt > 500000 || leapt < -500000);
+      if (status != NTP_REPLY_OK || delay < 0 || straddled) {
+        this->_rejected++; // a negative round trip means corrupted timestamps
+      } else {
+        NTPSample& sample     = peer.samples[peer.received++];
+        sample.offset         = ((t2 - t1) + (t3 - t4)) / 2;
+        sample.delay          = delay;
+        sample.received       = arrived;
+        peer.stratum          = reply.stratum();
+        peer.leap             = reply.leap();
+        peer.rootDelay        = reply.rootDelayMicros();
+        peer.rootDispersion   = reply.rootDispersionMicros();
+        peer.remote           = this->_udp->remoteIP();
+      }
+      this->nextRequest(peer);
+    }
+    if (!matched) this->_rejected++;
+  } else if (cb != 0) {
+    this->_udp->flush(); // runt, not an NTP reply
+    this->_rejected++;
+  }
+
+  // Read the clock again: a reply above may have sent the next request of its burst, later than `received`
+  uint64_t now = monotonicMicros();
+  bool waiting = false;
+  for (uint8_t i = 0; i < this->_serverCount; i++) {
+    NTPPeer& peer = this->_peers[i];
+    if (peer.waiting && now - peer.requestSent >= (uint64_t)this->_updateTimeout * 1000) {
+      peer.waiting = false;
+      // This one is lost, the rest of the burst may not be; a server that has not answered at all is given up on
+      if (peer.received > 0) this->nextRequest(peer);
+    }
+    waiting |= peer.waiting;
+  }
+  if (waiting) return false;
+
+  return this->selectAndSet();
+}
+
+void NTPClient::nextRequest(NTPPeer& peer) {
+  if (peer.sent < this->_burstSize && this->sendNTPPacket(peer)) {
+    peer.sent++;
+    peer.waiting = true;
+  }
+}
+
+bool NTPClient::selectAndSet() {
+  // The quickest reply of each burst stands for its server: queueing only ever adds delay, and with it asymmetry.
+  // Its error is bounded by half the round trip plus the burst's jitter, and a millisecond for everything else
+  uint8_t candidates[NTP_MAX_SERVERS];
+  int64_t low[NTP_MAX_SERVERS];
+  int64_t high[NTP_MAX_SERVERS];
+  uint8_t count = 0;
+  this->_sampleCount = 0;
+  for (uint8_t i = 0; i < this->_serverCount; i++) {
+    NTPPeer& peer = this->_peers[i];
+    peer.reach <<= 1;
+    peer.selected = false;
+    if (peer.received == 0) {
+      this->nextAddress(peer);
+      continue;
+    }
+    peer.reach |= 1;
+    this->_sampleCount += peer.received;
+
+    peer.best = 0;
+    for (uint8_t j = 1; j < peer.received; j++) {
+      if (peer.samples[j].delay < peer.samples[peer.best].delay) peer.best = j;
+    }
+    const NTPSample& best = peer.samples[peer.best];
+    // Jitter: RMS distance of the other samples from the chosen one
+    double sum = 0;
+    for (uint8_t j = 0; j < peer.received; j++) {
+      double difference = peer.samples[j].offset - best.offset;
+      sum += difference * difference;
+    }
+    peer.offset = best.offset;
+    peer.delay  = best.delay;
+    peer.jitter = peer.received > 1 ? sqrt(sum / (peer.received - 1)) : 0;
+
+    int64_t distance = peer.delay / 2 + peer.jitter + 1000;
+    low[count]  = peer.offset - distance;
+    high[count] = peer.offset + distance;
+    candidates[count++] = i;
+  }
+  if (count == 0) {
+    this->finishUpdate(false);
+    return false;
+  }
+
+  // Marzullo's algorithm: find the offsets most error intervals agree on. A server whose interval misses them is a
+  // falseticker; without a majority nobody can be trusted
+  int64_t agreedLow = 0, agreedHigh = 0;
+  uint8_t agreeing = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    // The best region starts at some interval's low end; count the intervals covering that point
+    uint8_t covering = 0;
+    int64_t end = INT64_MAX;
+    for (uint8_t j = 0; j < count; j++) {
+      if (low[j] <= low[i] && low[i] <= high[j]) {
+        covering++;
+        if (high[j] < end) end = high[j];
+      }
+    }
+    if (covering > agreeing) {
+      agreeing   = covering;
+      agreedLow  = low[i];
+      agreedHigh = end;
+    }
+  }
+  if (2 * agreeing <= count) {
+    this->finishUpdate(false);
+    return false;
+  }
+
+  // Combine the truechimers, weighted by the inverse of their error bound; the most accurate one anchors the time
+  double weights = 0;
+  double weighted = 0;
+  const NTPPeer* system = NULL;
+  for (uint8_t i = 0; i < count; i++) {
+    if (low[i] > agreedLow || high[i] < agreedHigh) continue;
+    NTPPeer& peer = this->_peers[candidates[i]];
+    peer.selected = true;
+    double weight = 1.0 / (high[i] - low[i]);
+    weights  += weight;
+    weighted += weight * peer.offset;
+    if (!system || high[i] - low[i] < 2 * (system->delay / 2 + system->jitter + 1000)) system = &peer;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    if (!this->_peers[candidates[i]].selected) this->nextAddress(this->_peers[candidates[i]]);
+  }
+  const NTPSample& anchor = system->samples[system->best];
+  this->_offset = (int64_t)(weighted / weights);
+  this->_delay  = system->delay;
+  this->_jitter = system->jitter;
+  this->_stratum        = system->stratum < 15 ? system->stratum + 1 : 16;
+  this->_referenceIP    = system->remote;
+  this->_rootDelay      = system->rootDelay + system->delay;
+  this->_rootDispersion = system->rootDispersion + system->jitter + 1000;
+
+  // Small offsets are slewed out and teach the discipline the drift, large ones step the clock
+  this->_discipline.sample(this->localMicrosSinceUpdate(anchor.received), this->_offset, this->_delay);
+  this->_lastUpdate = anchor.received;
+  this->_timeSet    = true;
+  this->scheduleLeap(system->leap);
+  this->reportPoll();
+
+  this->finishUpdate(true);
+  return true;  // return true after successful update
+}
+
+void NTPClient::finishUpdate(bool success) {
+  this->_updatePending = false;
+  if (this->_updateCallback) this->_updateCallback(success);
+}
+
+bool NTPClient::isUpdating() const {
+  return this->_updatePending;
+}
+
+bool NTPClient::isUpdateDue() const {
+  return !this->_timeSet                                                                  // No update yet
+    || monotonicMicros() - this->_lastUpdate >= (uint64_t)this->getUpdateInterval() * 1000; // Interval is over
+}
+
+bool NTPClient::update() {
+  if (this->isUpdateDue()) {
+    if (!this->_udpSetup || this->_port != NTP_DEFAULT_LOCAL_PORT) this->begin(this->_port); // setup the UDP client if needed
+    return this->forceUpdate();
+  }
+  return false;   // return false if update does not occur
+}
+
+void NTPClient::setEstimatedTime(uint64_t utcMicros) {
+  this->_discipline.estimate(this->localMicrosSinceUpdate(monotonicMicros()), utcMicros);
+}
+
+bool NTPClient::isTimeSet() const {
+  return this->_timeSet; // returns true if the time has been set, else false
+}
+
+uint64_t NTPClient::getEpochTime() const {
+  return this->getEpochMicros() / 1000000;
+}
+
+uint64_t NTPClient::getEpochMillis() const {
+  return this->getEpochMicros() / 1000;
+}
+
+uint64_t NTPClient::getEpochMicros() const {
+  return (uint64_t)this->_timeOffset * 1000000 + // User offset
+         this->utcMicrosAt(monotonicMicros());   // UTC now
+}
+
+uint64_t NTPClient::utcMicrosAt(uint64_t now) const {
+  uint64_t time = this->_discipline.timeAt(this->localMicrosSinceUpdate(now));
+  return time + this->leapCorrectionAt(time, true);
+}
+
+uint64_t NTPClient::steppedMicrosAt(uint64_t now) const {
+  uint64_t time = this->_discipline.timeAt(this->localMicrosSinceUpdate(now));
+  return time + this->leapCorrectionAt(time, false);
+}
+
+int64_t NTPClient::leapCorrectionAt(uint64_t time, bool smeared) const {
+  if (this->_leap == NTP_LEAP_NONE) return 0;
+  int64_t step = this->_leap == NTP_LEAP_INSERT ? -1000000 : 1000000;
+  if (smeared && this->_leapSmear) {
+    // Spread evenly over the window centred on the midnight
+    uint64_t half = (uint64_t)this->_leapSmear * 500000;
+    if (time <= this->_leapAt - half) return 0;
+    if (time >= this->_leapAt + half) return step;
+    return step * (int64_t)(time - (this->_leapAt - half)) / (int64_t)(2 * half);
+  }
+  // An inserted second repeats 23:59:59, a deleted one skips it
+  uint64_t at = this->_leap == NTP_LEAP_INSERT ? this->_leapAt : this->_leapAt - 1000000;
+  return time >= at ? step : 0;
+}
+
+// Month (1-12) of a day counted from Jan. 1, 1970
+static uint8_t monthOfDay(uint32_t day) {
+  long    year;
+  uint8_t month, dayOfMonth;
+  CivilDate::civilFromDays(day, year, month, dayOfMonth);
+  return month;
+}
+
+void NTPClient::scheduleLeap(uint8_t leap) {
+  uint64_t time = this->_discipline.timeAt(this->localMicrosSinceUpdate(monotonicMicros()));
+  uint32_t day = (time + this->leapCorrectionAt(time, false)) / 86400000000ULL;
+  if (leap == NTP_LEAP_INSERT || leap == NTP_LEAP_DELETE) {
+    // Leap seconds only ever end a month; that also ignores servers still announcing one after it happened
+    if (monthOfDay(day) == monthOfDay(day + 1)) return;
+    this->_leap   = leap;
+    this->_leapAt = (uint64_t)(day + 1) * 86400000000ULL;
+  } else if (this->_leap != NTP_LEAP_NONE) {
+    // Withdrawn, unless it is already under way
+    uint64_t start = this->_leapSmear ? this->_leapAt - (uint64_t)this->_leapSmear * 500000 : this->_leapAt - 1000000;
+    if (time < start) this->_leap = NTP_LEAP_NONE;
+  }
+}
+
+void NTPClient::foldLeap() {
+  // Once the leap second is over the clock itself is moved by it, and the correction dropped
+  if (this->_leap == NTP_LEAP_NONE) return;
+  uint64_t elapsed = this->localMicrosSinceUpdate(monotonicMicros());
+  uint64_t time = this->_discipline.timeAt(elapsed);
+  uint64_t end = this->_leapAt + (this->_leapSmear ? (uint64_t)this->_leapSmear * 500000 : 1000000);
+  if (time < end) return;
+  this->_discipline.estimate(elapsed, time + this->leapCorrectionAt(time, false));
+  this->_leap = NTP_LEAP_NONE;
+}
+
+uint64_t NTPClient::localMicrosSinceUpdate(uint64_t now) const {
+  // Right however long ago the last update was; a millis() difference would be 49.7 days short after a wrap
+  return now - this->_lastUpdate;
+}
+
+int64_t NTPClient::getOffsetMicros() const {
+  return this->_offset;
+}
+
+long NTPClient::getDelayMicros() const {
+  return this->_delay;
+}
+
+long NTPClient::getJitterMicros() const {
+  return this->_jitter;
+}
+
+uint8_t NTPClient::getSampleCount() const {
+  return this->_sampleCount;
+}
+
+unsigned long NTPClient::getRejectedCount() const {
+  return this->_rejected;
+}
+
+uint64_t NTPClient::getUtcMicros() const {
+  return this->utcMicrosAt(monotonicMicros());
+}
+
+uint64_t NTPClient::getUtcMicrosAt(uint64_t monotonic) const {
+  return this->utcMicrosAt(monotonic);
+}
+
+uint8_t NTPClient::getStratum() const {
+  return this->isTimeSet() ? this->_stratum : 16;
+}
+
+IPAddress NTPClient::getReferenceIP() const {
+  return this->_referenceIP;
+}
+
+uint64_t NTPClient::getReferenceMicros() const {
+  return this->isTimeSet() ? this->utcMicrosAt(this->_lastUpdate) : 0;
+}
+
+unsigned long NTPClient::getRootDelayMicros() const {
+  return this->_rootDelay;
+}
+
+unsigned long NTPClient::getRootDispersionMicros() const {
+  // Grows by the frequency tolerance (15 ppm, RFC 5905) while the clock runs on its own
+  return this->_rootDispersion + this->localMicrosSinceUpdate(monotonicMicros()) * 15 / 1000000;
+}
+
+uint8_t NTPClient::getLeapIndicator() const {
+  return this->steppedMicrosAt(monotonicMicros()) < this->_leapAt ? this->_leap : NTP_LEAP_NONE;
+}
+
+uint64_t NTPClient::getLeapTime() const {
+  return this->getLeapIndicator() != NTP_LEAP_NONE ? this->_leapAt / 1000000 : 0;
+}
+
+void NTPClient::setLeapSmear(unsigned long seconds) {
+  this->_leapSmear = min(seconds, (unsigned long)NTP_MAX_LEAP_SMEAR);
+}
+
+unsigned long NTPClient::getLeapSmear() const {
+  return this->_leapSmear;
+}
+
+void NTPClient::setBurstSize(uint8_t burstSize) {
+  this->_burstSize = constrain(burstSize, (uint8_t)1, (uint8_t)NTP_MAX_BURST);
+}
+
+unsigned long NTPClient::getMillisIntoSecond() const {
+  return this->getEpochMillis() % 1000;
+}
+
+int NTPClient::getDay() const {
+  return (((this->getEpochTime()  / 86400L) + 4 ) % 7); //0 is Sunday
+}
+int NTPClient::getHours() const {
+  return ((this->getEpochTime()  % 86400L) / 3600);
+}
+int NTPClient::getMinutes() const {
+  return ((this->getEpochTime() % 3600) / 60);
+}
+int NTPClient::getSeconds() const {
+  return (this->getEpochTime() % 60);
+}
+
+String NTPClient::getFormattedTime() const {
+  uint64_t rawTime = this->getEpochTime();
+  unsigned long hours = (rawTime % 86400L) / 3600;
+  String hoursStr = hours < 10 ? "0" + String(hours) : String(hours);
+
+  unsigned long minutes = (rawTime % 3600) / 60;
+  String minuteStr = minutes < 10 ? "0" + String(minutes) : String(minutes);
+
+  unsigned long seconds = rawTime % 60;
+  String secondStr = seconds < 10 ? "0" + String(seconds) : String(seconds);
+
+  return hoursStr + ":" + minuteStr + ":" + secondStr;
+}
+
+void NTPClient::end() {
+  this->_udp->stop();
+
+  this->_udpSetup = false;
+}
+
+void NTPClient::setTimeOffset(int timeOffset) {
+  this->_timeOffset     = timeOffset;
+}
+
+void NTPClient::setUpdateInterval(unsigned long updateInterval) {
+  this->_updateInterval = updateInterval;
+  this->_adaptiveInterval = false;
+}
+
+unsigned long NTPClient::getUpdateInterval() const {
+  return this->_adaptiveInterval ? this->_discipline.pollInterval() : this->_updateInterval;
+}
+
+NTPPollReason NTPClient::getPollReason() const {
+  return this->_discipline.getPollReason();
+}
+
+void NTPClient::restartPoll() {
+  this->_discipline.restartPoll();
+  this->reportPoll();
+}
+
+void NTPClient::setPollCallback(NTPPollCallback callback) {
+  this->_pollCallback = callback;
+}
+
+void NTPClient::reportPoll() {
+  if (this->_pollCallback && this->_adaptiveInterval && this->_discipline.getPollReason() != NTP_POLL_KEPT) {
+    this->_pollCallback(this->_discipline.pollInterval(), this->_discipline.getPollReason());
+  }
+}
+
+double NTPClient::getDriftPpm() const {
+  return this->_discipline.getDriftPpm();
+}
+
+double NTPClient::getDriftErrorPpm() const {
+  return this->_discipline.getDriftErrorPpm();
+}
+
+void NTPClient::setDriftPpm(double drift, double error) {
+  this->_discipline.setDriftPpm(drift, error);
+}
+
+void NTPClient::setUpdateCallback(NTPUpdateCallback callback) {
+  this->_updateCallback = callback;
+}
+
+void NTPClient::setUpdateTimeout(unsigned long timeout) {
+  this->_updateTimeout = timeout;
+}
+
+void NTPClient::setPoolServerName(const char* poolServerName) {
+    this->_poolServerName = poolServerName;
+}
+
+bool NTPClient::addServer(const char* serverName) {
+  if (this->_serverCount >= NTP_MAX_SERVERS) return false;
+  NTPPeer& peer = this->_peers[this->_serverCount++];
+  peer.name = serverName;
+  return true;
+}
+
+bool NTPClient::addServer(IPAddress serverIP) {
+  if (this->_serverCount >= NTP_MAX_SERVERS) return false;
+  NTPPeer& peer = this->_peers[this->_serverCount++];
+  peer.name = NULL;
+  peer.ip   = serverIP;
+  return true;
+}
+
+uint8_t NTPClient::getServerCount() const {
+  return this->_serverCount;
+}
+
+const NTPPeer& NTPClient::getServer(uint8_t index) const {
+  return this->_peers[index < this->_serverCount ? index : 0];
+}
+
+void NTPClient::setResolver(NTPResolver resolver) {
+  this->_resolver = resolver;
+}
+
+void NTPClient::setArrivalTime(NTPArrivalTime arrivalTime) {
+  this->_arrivalTime = arrivalTime;
+}
+
+unsigned long NTPClient::resolveServers() {
+  this->refreshPoolPeer();
+  unsigned long next = NTP_MAX_DNS_TTL * 1000UL;
+  for (uint8_t i = 0; i < this->_serverCount; i++) {
+    NTPPeer& peer = this->_peers[i];
+    if (!this->_resolver || !peer.name) continue;
+    if (this->isResolveDue(peer, monotonicMicros())) this->resolve(peer);
+    unsigned long remaining = peer.ttl - (monotonicMicros() - peer.resolvedAt) / 1000;
+    if (remaining < next) next = remaining;
+  }
+  return next;
+}
+
+bool NTPClient::setServerAddresses(uint8_t index, const IPAddress* addresses, uint8_t count) {
+  if (index >= this->_serverCount) return false;
+  this->refreshPoolPeer();
+  NTPPeer& peer = this->_peers[index];
+  peer.addressCount = count < NTP_MAX_ADDRESSES ? count : NTP_MAX_ADDRESSES;
+  peer.address      = 0;
+  for (uint8_t i = 0; i < peer.addressCount; i++) peer.addresses[i] = addresses[i];
+  peer.resolvedAt   = monotonicMicros();
+  peer.ttl          = peer.addressCount ? NTP_DNS_RETRY * 1000UL : 0;
+  return true;
+}
+
+bool NTPClient::addServerAddresses(uint8_t index, const IPAddress* addresses, uint8_t count, unsigned long ttl) {
+  if (index >= this->_serverCount || count == 0) return false;
+  this->refreshPoolPeer();
+  NTPPeer& peer = this->_peers[index];
+  if (!this->_resolver || !peer.name) return false;
+  IPAddress found[NTP_MAX_ADDRESSES];
+  if (count > NTP_MAX_ADDRESSES) count = NTP_MAX_ADDRESSES;
+  for (uint8_t i = 0; i < count; i++) found[i] = addresses[i];
+  this->mergeAddresses(peer, found, count, ttl);
+  peer.resolvedAt = monotonicMicros();
+  return true;
+}
+
+void NTPClient::refreshPoolPeer() {
+  NTPPeer& peer = this->_peers[0];
+  if (peer.name != this->_poolServerName) {
+    peer.addressCount = 0;
+    peer.address      = 0;
+    peer.ttl          = 0;
+  }
+  peer.name = this->_poolServerName;
+  peer.ip   = this->_poolServerIP;
+}
+
+bool NTPClient::isResolveDue(const NTPPeer& peer, uint64_t now) const {
+  return this->_resolver && peer.name && (peer.ttl == 0 || now - peer.resolvedAt >= (uint64_t)peer.ttl * 1000);
+}
+
+bool NTPClient::resolve(NTPPeer& peer) {
+  IPAddress found[NTP_MAX_ADDRESSES];
+  unsigned long ttl = NTP_DEFAULT_DNS_TTL;
+  uint8_t count = this->_resolver(peer.name, found, NTP_MAX_ADDRESSES, ttl);
+  peer.resolvedAt = monotonicMicros();
+  if (count == 0) {
+    // Keep the old addresses meanwhile, they are likely still good
+    peer.ttl = NTP_DNS_RETRY * 1000UL;
+    return false;
+  }
+  this->mergeAddresses(peer, found, count, ttl);
+  return true;
+}
+
+void NTPClient::mergeAddresses(NTPPeer& peer, IPAddress* found, uint8_t count, unsigned long ttl) {
+  if (count > NTP_MAX_ADDRESSES) count = NTP_MAX_ADDRESSES;
+
+  // The answer goes first and the older addresses it lacks fill up the rest, so a resolver that returns one address
+  // of a pool at a time still builds up a few to fall back on. The address in use stays in use
+  IPAddress current = peer.addresses[peer.address];
+  bool hadCurrent = peer.addressCount > 0;
+  for (uint8_t i = 0; i < peer.addressCount && count < NTP_MAX_ADDRESSES; i++) {
+    bool known = false;
+    for (uint8_t j = 0; j < count && !known; j++) known = found[j] == peer.addresses[i];
+    if (!known) found[count++] = peer.addresses[i];
+  }
+  peer.address = 0;
+  bool kept = false;
+  for (uint8_t i = 0; i < count; i++) {
+    peer.addresses[i] = found[i];
+    if (hadCurrent && found[i] == current) {
+      peer.address = i;
+      kept = true;
+    }
+  }
+  if (!kept) peer.kiss = 0;
+  peer.addressCount = count;
+  peer.ttl = constrain(ttl, 1UL, (unsigned long)NTP_MAX_DNS_TTL) * 1000UL;
+}
+
+void NTPClient::nextAddress(NTPPeer& peer) {
+  if (peer.addressCount > 1) {
+    peer.address = (peer.address + 1) % peer.addressCount;
+    peer.kiss    = 0; // a kiss-o'-death is for the address that sent it
+  } else {
+    peer.ttl = 0; // nothing to fall back on, look the name up again
+  }
+}
+
+bool NTPClient::sendNTPPacket(NTPPeer& peer) {
+  int started;
+  if (peer.name && this->_resolver) {
+    if (peer.addressCount == 0) return false; // never resolved
+    started = this->_udp->beginPacket(peer.addresses[peer.address], 123);
+  } else if (peer.name) {
+    started = this->_udp->beginPacket(peer.name, 123);
+  } else {
+    started = this->_udp->beginPacket(peer.ip, 123);
+  }
+  if (!started) return false;
+
+  // T1: our clock at transmission, echoed back by the server as the originate timestamp. Requests sent within the
+  // same microsecond are nudged apart so that every reply can be told apart. That is done before the leap second
+  // correction, which can step back
+  peer.requestSent = monotonicMicros();
+  uint64_t time = this->_discipline.timeAt(this->localMicrosSinceUpdate(peer.requestSent));
+  if (time <= this->_lastRequestTimestamp) time = this->_lastRequestTimestamp + 1;
+  this->_lastRequestTimestamp = time;
+  peer.requestTimestamp = time + this->leapCorrectionAt(time, false);
+  NTPPacket(this->_packetBuffer).makeRequest(peer.requestTimestamp);
+
+  this->_udp->write(this->_packetBuffer, NTP_PACKET_SIZE);
+  return this->_udp->endPacket() != 0;
+}
+
+void NTPClient::setRandomPort(unsigned int minValue, unsigned int maxValue) {
+  randomSeed(analogRead(0));
+  this->_port = random(minValue, maxValue);
+}
@@ -0,0 +1,479 @@
+#pragma once
+
+#include "Arduino.h"
+
+#include <Udp.h>
+
+#include "ClockDiscipline.h"
+#include "MonotonicClock.h"
+#include "NTPPacket.h"
+
+#define NTP_DEFAULT_LOCAL_PORT 1337
+#define NTP_DEFAULT_TIMEOUT 1000
+#define NTP_MAX_BURST 8
+#define NTP_MAX_SERVERS 4
+#define NTP_MAX_ADDRESSES 4
+#define NTP_DEFAULT_DNS_TTL 3600                // In s, for resolvers that cannot tell
+#define NTP_MAX_DNS_TTL 86400                   // In s
+#define NTP_DNS_RETRY 60                        // In s, before a failed lookup is tried again
+#define NTP_MAX_LEAP_SMEAR 86400                // In s; half of it fits in the day the leap second is announced
+
+typedef void (*NTPUpdateCallback)(bool success);
+
+/**
+ * Told when the adaptive update interval changed: the new interval in ms and why.
+ */
+typedef void (*NTPPollCallback)(unsigned long interval, NTPPollReason reason);
+
+/**
+ * Looks up host and stores up to maxAddresses of its addresses. ttl comes preset to NTP_DEFAULT_DNS_TTL and may be
+ * set to the record's, in seconds. A resolver that cannot wait for the answer returns 0 and hands it in later
+ * through NTPClient::addServerAddresses().
+ *
+ * @return number of addresses stored, 0 if the lookup failed
+ */
+typedef uint8_t (*NTPResolver)(const char* host, IPAddress* addresses, uint8_t maxAddresses, unsigned long& ttl);
+
+/**
+ * Tells when the datagram the last parsePacket() returned arrived, as noted by the network stack.
+ *
+ * @return monotonicMicros() at its arrival, 0 if unknown
+ */
+typedef uint64_t (*NTPArrivalTime)();
+
+struct NTPSample {
+  int64_t       offset;                 // In us, server minus our clock
+  long          delay;                  // In us, round trip
+  uint64_t      received;               // monotonicMicros() when the reply arrived
+};
+
+/**
+ * One time server and what the last update learned from it. NTPClient owns these; read them through getServer().
+ */
+struct NTPPeer {
+  const char*   name;                   // NULL when addressed by ip
+  IPAddress     ip;
+  uint8_t       reach;                  // One bit per update, set if it answered; the latest is bit 0
+  bool          selected;               // Agreed with the majority in the last update
+  int64_t       offset;                 // In us, best sample of the last burst
+  long          delay;                  // In us, round trip of that sample
+  long          jitter;                 // In us, spread of the burst around it
+  uint8_t       stratum;                // Of its last reply
+  uint8_t       leap;                   // Leap indicator of its last reply
+  unsigned long rootDelay;              // In us, its own round trip to its reference clock
+  unsigned long rootDispersion;         // In us, its own error bound
+  IPAddress     remote;                 // Where its last reply came from
+  uint32_t      kiss;                   // Code of its last kiss-o'-death, 0 if none
+
+  // Burst in progress
+  bool          waiting;                // A request is outstanding
+  uint8_t       sent;
+  uint8_t       received;
+  uint8_t       best;                   // Index of the quickest sample
+  uint64_t      requestSent;            // monotonicMicros() when the outstanding request went out
+  uint64_t      requestTimestamp;       // In us since 1970 on our clock, T1 of the outstanding request
+  NTPSample     samples[NTP_MAX_BURST];
+
+  // Address cache, only used with a resolver
+  IPAddress     addresses[NTP_MAX_ADDRESSES]; // Latest answer first
+  uint8_t       addressCount;
+  uint8_t       address;                // Index of the one in use
+  uint64_t      resolvedAt;             // monotonicMicros() of the last lookup, successful or not
+  unsigned long ttl;                    // In ms, how long that lookup holds; 0 before the first one
+};
+
+class NTPClient {
+  private:
+    UDP*          _udp;
+    bool          _udpSetup       = false;
+
+    const char*   _poolServerName = "pool.ntp.org"; // Default time server
+    IPAddress     _poolServerIP;
+    unsigned int  _port           = NTP_DEFAULT_LOCAL_PORT;
+    long          _timeOffset     = 0;
+
+    unsigned long _updateInterval = 60000;  // In ms
+    bool          _adaptiveInterval = true; // Poll as the discipline suggests until an interval is set
+
+    ClockDiscipline _discipline;            // Time since _lastUpdate to UTC
+    uint64_t      _lastUpdate     = 0;      // monotonicMicros() at the last update, boot before the first
+    bool          _timeSet        = false;
+
+    bool          _updatePending  = false;
+    NTPPeer       _peers[NTP_MAX_SERVERS] = {}; // [0] mirrors _poolServerName/_poolServerIP
+    uint8_t       _serverCount    = 1;
+    uint64_t      _lastRequestTimestamp = 0; // In us, T1 of the latest request before leap correction, to keep them unique
+    int64_t       _offset         = 0;      // In us, server minus our clock, from the last update
+    long          _delay          = 0;      // In us, round-trip network delay of the last update
+    long          _jitter         = 0;      // In us, spread of the last burst around the chosen sample
+    uint8_t       _burstSize      = 1;
+    uint8_t       _sampleCount    = 0;
+    unsigned long _rejected       = 0;
+    uint8_t       _stratum        = 16;     // Advertised when serving time; 16 is unsynchronized
+    IPAddress     _referenceIP;
+    unsigned long _rootDelay      = 0;      // In us
+    unsigned long _rootDispersion = 0;      // In us, at the last update
+    unsigned long _updateTimeout  = NTP_DEFAULT_TIMEOUT; // In ms
+    uint8_t       _leap           = NTP_LEAP_NONE; // Leap second announced and not yet folded into the clock
+    uint64_t      _leapAt         = 0;      // In us since 1970, the midnight it ends at
+    unsigned long _leapSmear      = 0;      // In s, window it is smeared over; 0 steps it
+    NTPUpdateCallback _updateCallback = NULL;
+    NTPPollCallback _pollCallback = NULL;
+    NTPResolver   _resolver       = NULL;
+    NTPArrivalTime _arrivalTime   = NULL;
+
+    byte          _packetBuffer[NTP_PACKET_SIZE];
+
+    bool          sendNTPPacket(NTPPeer& peer);
+    void          nextRequest(NTPPeer& peer);
+    bool          selectAndSet();
+    void          refreshPoolPeer();
+    bool          isResolveDue(const NTPPeer& peer, uint64_t now) const;
+    bool          resolve(NTPPeer& peer);
+    void          mergeAddresses(NTPPeer& peer, IPAddress* found, uint8_t count, unsigned long ttl);
+    void          nextAddress(NTPPeer& peer);
+    void          finishUpdate(bool success);
+    void          reportPoll();
+    uint64_t      utcMicrosAt(uint64_t now) const;
+    uint64_t      steppedMicrosAt(uint64_t now) const;
+    int64_t       leapCorrectionAt(uint64_t time, bool smeared) const;
+    void          scheduleLeap(uint8_t leap);
+    void          foldLeap();
+    uint64_t      localMicrosSinceUpdate(uint64_t now) const;
+
+  public:
+    NTPClient(UDP& udp);
+    NTPClient(UDP& udp, long timeOffset);
+    NTPClient(UDP& udp, const char* poolServerName);
+    NTPClient(UDP& udp, const char* poolServerName, long timeOffset);
+    NTPClient(UDP& udp, const char* poolServerName, long timeOffset, unsigned long updateInterval);
+    NTPClient(UDP& udp, IPAddress poolServerIP);
+    NTPClient(UDP& udp, IPAddress poolServerIP, long timeOffset);
+    NTPClient(UDP& udp, IPAddress poolServerIP, long timeOffset, unsigned long updateInterval);
+
+    /**
+     * Set time server name
+     *
+     * @param poolServerName
+     */
+    void setPoolServerName(const char* poolServerName);
+
+    /**
+     * Query this server as well (up to NTP_MAX_SERVERS in all, counting the pool server). All servers are asked in
+     * parallel; those that disagree with the majority are ignored and those that do not answer are skipped.
+     *
+     * @return false if the list is full
+     */
+    bool addServer(const char* serverName);
+    bool addServer(IPAddress serverIP);
+
+    /**
+     * @return number of servers queried, including the pool server
+     */
+    uint8_t getServerCount() const;
+
+    /**
+     * @return reachability and the last measurements of a server; 0 is the pool server
+     */
+    const NTPPeer& getServer(uint8_t index) const;
+
+    /**
+     * Look server names up through resolver and cache the addresses, instead of having every request resolve the
+     * name again. Each answer is kept for its TTL and merged with the previous ones, up to NTP_MAX_ADDRESSES per
+     * name; a server that fails to answer or is outvoted moves on to its next address. A failed lookup keeps the old
+     * addresses and is retried after NTP_DNS_RETRY seconds.
+     */
+    void setResolver(NTPResolver resolver);
+
+    /**
+     * Seed the address cache of a server, e.g. with addresses saved before a reboot, so the first update needs no
+     * DNS. They are used right away and looked up again after NTP_DNS_RETRY seconds.
+     *
+     * @return false if there is no such server
+     */
+    bool setServerAddresses(uint8_t index, const IPAddress* addresses, uint8_t count);
+
+    /**
+     * Hand in the answer to a lookup the resolver started but did not wait for. It is merged into the cache and kept
+     * for ttl seconds, as if the resolver had returned it.
+     *
+     * @return false if there is no such server or it is not looked up through a resolver
+     */
+    bool addServerAddresses(uint8_t index, const IPAddress* addresses, uint8_t count,
+                            unsigned long ttl = NTP_DEFAULT_DNS_TTL);
+
+    /**
+     * Look up the server names whose cached addresses have expired. Called between updates it keeps DNS out of
+     * them; otherwise beginUpdate() does the lookups, blocking for as long as they take.
+     *
+     * @return ms until the next cached entry expires
+     */
+    unsigned long resolveServers();
+
+    /**
+     * Take T4, the arrival time of a reply, from the network stack instead of reading the clock when poll() finds
+     * the reply. A reply waits in the socket until the next poll(), so without this the measured offset is off by
+     * half that wait and the round trip by all of it. A stamp of 0, or one later than the poll, is not used.
+     */
+    void setArrivalTime(NTPArrivalTime arrivalTime);
+
+     /**
+     * Set random local port
+     */
+    void setRandomPort(unsigned int minValue = 49152, unsigned int maxValue = 65535);
+
+    /**
+     * Starts the underlying UDP client with the default local port
+     */
+    void begin();
+
+    /**
+     * Starts the underlying UDP client with the specified local port
+     */
+    void begin(unsigned int port);
+
+    /**
+     * This should be called in the main loop of your application. An update from the NTP Server is only made once
+     * getUpdateInterval() has passed since the last one. The interval adapts to the clock by default; a fixed one
+     * can be set in the NTPClient constructor.
+     *
+     * @return true on success, false on failure
+     */
+    bool update();
+
+    /**
+     * This will force the update from the NTP Server. Blocks until the reply arrives or the timeout expires.
+     *
+     * @return true on success, false on failure
+     */
+    bool forceUpdate();
+
+    /**
+     * @return true when update() would contact the NTP Server
+     */
+    bool isUpdateDue() const;
+
+    /**
+     * Sends a request to the NTP Server and returns right away. The reply is picked up by poll(); a transaction
+     * that is already outstanding is abandoned.
+     *
+     * @return true if the request was sent
+     */
+    bool beginUpdate();
+
+    /**
+     * Checks for the reply to beginUpdate() without blocking. Call it from the main loop while isUpdating() is
+     * true. The update callback runs from here when the transaction succeeds or times out.
+     *
+     * @return true if the time was set by this call
+     */
+    bool poll();
+
+    /**
+     * @return true while a request sent by beginUpdate() is outstanding
+     */
+    bool isUpdating() const;
+
+    /**
+     * Called with the outcome of every transaction, blocking or not
+     */
+    void setUpdateCallback(NTPUpdateCallback callback);
+
+    /**
+     * Set how long to wait for a reply before giving up (default 1000 ms)
+     */
+    void setUpdateTimeout(unsigned long timeout);
+
+    /**
+     * Show this time until the first update, e.g. one saved before a reboot. isTimeSet() stays false and the
+     * first update steps the clock from here.
+     *
+     * @param utcMicros UTC in microseconds since 1970, without the time offset
+     */
+    void setEstimatedTime(uint64_t utcMicros);
+
+    /**
+     * This allows to check if the NTPClient successfully received a NTP packet and set the time.
+     *
+     * @return true if time has been set, else false
+     */
+    bool isTimeSet() const;
+
+    int getDay() const;
+    int getHours() const;
+    int getMinutes() const;
+    int getSeconds() const;
+
+    /**
+     * Changes the time offset. Useful for changing timezones dynamically
+     */
+    void setTimeOffset(int timeOffset);
+
+    /**
+     * Set the update interval to another frequency. E.g. useful when the
+     * timeOffset should not be set in the constructor. This turns off the
+     * adaptive interval (64 s growing to 1024 s as the clock settles) used
+     * by default.
+     */
+    void setUpdateInterval(unsigned long updateInterval);
+
+    /**
+     * @return the interval update() currently waits between syncs, in ms
+     */
+    unsigned long getUpdateInterval() const;
+
+    /**
+     * @return why the adaptive interval last changed
+     */
+    NTPPollReason getPollReason() const;
+
+    /**
+     * Go back to the shortest adaptive interval and measure the round trip afresh, e.g. after the network
+     * reconnected: the path to the servers may have changed. The time and the drift estimate are kept.
+     */
+    void restartPoll();
+
+    /**
+     * Called whenever the adaptive interval changes, from update(), poll() or restartPoll()
+     */
+    void setPollCallback(NTPPollCallback callback);
+
+    /**
+     * @return estimated frequency error of the local clock, positive when it runs fast, in ppm
+     */
+    double getDriftPpm() const;
+
+    /**
+     * @return standard error of getDriftPpm(), in ppm
+     */
+    double getDriftErrorPpm() const;
+
+    /**
+     * Seed the drift estimate, e.g. from a value saved before a reboot along with its getDriftErrorPpm()
+     */
+    void setDriftPpm(double drift, double error = 1);
+
+    /**
+     * @return time formatted like `hh:mm:ss`
+     */
+    String getFormattedTime() const;
+
+    /**
+     * @return time in seconds since Jan. 1, 1970, 64 bits wide: unaffected by the 2036 NTP era rollover or by 2038
+     */
+    uint64_t getEpochTime() const;
+
+    /**
+     * @return time in milliseconds since Jan. 1, 1970, including the offset
+     */
+    uint64_t getEpochMillis() const;
+
+    /**
+     * @return time in microseconds since Jan. 1, 1970, including the offset
+     */
+    uint64_t getEpochMicros() const;
+
+    /**
+     * @return clock offset measured by the last successful update (the agreeing servers' best samples, weighted by
+     *         their accuracy): server time minus our time before the update, in microseconds
+     */
+    int64_t getOffsetMicros() const;
+
+    /**
+     * @return round-trip network delay to the most accurate server in the last successful update, excluding the
+     *         server's processing time, in microseconds
+     */
+    long getDelayMicros() const;
+
+    /**
+     * @return RMS distance of the other samples of the most accurate server's last burst from the one that was used,
+     *         in microseconds; together with half the delay a measure of how far the time may be off
+     */
+    long getJitterMicros() const;
+
+    /**
+     * @return number of replies the last update got, from all servers
+     */
+    uint8_t getSampleCount() const;
+
+    /**
+     * @return replies thrown away so far: not matching a request of ours (stale, duplicated or spoofed), not valid
+     *         server replies, from unsynchronized servers, kisses-o'-death and ones with impossible timestamps
+     */
+    unsigned long getRejectedCount() const;
+
+    /**
+     * @return UTC now in microseconds since 1970, without the time offset; the time an NTPServer hands out
+     */
+    uint64_t getUtcMicros() const;
+
+    /**
+     * @return UTC in microseconds since 1970 at a monotonicMicros() reading, such as the arrival time of a request
+     */
+    uint64_t getUtcMicrosAt(uint64_t monotonic) const;
+
+    /**
+     * @return our stratum, one more than that of the server the clock follows; 16 until the first update
+     */
+    uint8_t getStratum() const;
+
+    /**
+     * @return address of the server the clock follows, the reference ID of served time
+     */
+    IPAddress getReferenceIP() const;
+
+    /**
+     * @return UTC of the last successful update, in microseconds since 1970; 0 before the first
+     */
+    uint64_t getReferenceMicros() const;
+
+    /**
+     * @return round-trip delay to the reference clock at the top of the chain, in microseconds
+     */
+    unsigned long getRootDelayMicros() const;
+
+    /**
+     * @return bound on the error against the reference clock, in microseconds: the server's own, our jitter and
+     *         precision, and 15 ppm of frequency tolerance for the time since the last update
+     */
+    unsigned long getRootDispersionMicros() const;
+
+    /**
+     * Servers announce a leap second during the day it ends (RFC 5905). One announced by the selected server on
+     * the last day of a month is applied at the following midnight UTC: the clock repeats 23:59:59 for an
+     * inserted second and skips it for a deleted one, like POSIX time, or smears it (see setLeapSmear()).
+     *
+     * @return NTP_LEAP_INSERT or NTP_LEAP_DELETE until that midnight, NTP_LEAP_NONE otherwise
+     */
+    uint8_t getLeapIndicator() const;
+
+    /**
+     * @return the midnight the announced leap second ends at, in seconds since Jan. 1, 1970; 0 if none
+     */
+    uint64_t getLeapTime() const;
+
+    /**
+     * Spread the leap second evenly over this many seconds (at most NTP_MAX_LEAP_SMEAR) centred on its midnight
+     * instead of stepping the clock; 0, the default, steps it. A smeared clock is off true UTC by up to half a
+     * second meanwhile, so it no longer announces the leap second when serving time.
+     */
+    void setLeapSmear(unsigned long seconds);
+    unsigned long getLeapSmear() const;
+
+    /**
+     * Send up to this many requests (at most NTP_MAX_BURST) per update, one after the other, and use the reply
+     * with the shortest round trip. Lost requests are skipped; the update only fails if all of them are.
+     */
+    void setBurstSize(uint8_t burstSize);
+
+    /**
+     * @return milliseconds since getEpochTime() last ticked (0-999), i.e.
+     *         1000 minus this is the time until the next second edge
+     */
+    unsigned long getMillisIntoSecond() const;
+
+    /**
+     * Stops the underlying UDP client
+     */
+    void end();
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define SEVENZYYEARS 2208988800UL
+#define NTP_PACKET_SIZE 48
+
+#define NTP_MODE_CLIENT 3
+#define NTP_MODE_SERVER 4
+#define NTP_LEAP_NONE 0
+#define NTP_LEAP_INSERT 1               // The last minute of the day has 61 seconds
+#define NTP_LEAP_DELETE 2               // The last minute of the day has 59 seconds
+#define NTP_LEAP_UNSYNCHRONIZED 3
+#define NTP_STRATUM_UNSYNCHRONIZED 16
+
+enum NTPReplyStatus : uint8_t {
+  NTP_REPLY_OK,
+  NTP_REPLY_BAD_MODE,                   // Not a server reply, or a version we do not speak
+  NTP_REPLY_UNSYNCHRONIZED,             // The server has no time to give: leap indicator 3 or stratum 16 and up
+  NTP_REPLY_KISS,                       // Kiss-o'-death (stratum 0), the reference ID says why
+  NTP_REPLY_BAD_TIMESTAMPS              // Receive or transmit timestamp missing, or sent before received
+};
+
+/**
+ * View of the 48-byte NTP header (RFC 5905) over a buffer, read and written in place: fields are decoded on
+ * access, nothing is copied. Timestamps convert to and from 64-bit microseconds since 1970, across the 2036 wrap of
+ * the NTP seconds; short-format fields (root delay and dispersion) to and from microseconds.
+ */
+class NTPPacket {
+  private:
+    byte*         _packet;
+
+    constexpr uint32_t read32(uint8_t at) const {
+      return (uint32_t)_packet[at] << 24 | (uint32_t)_packet[at + 1] << 16 | (uint32_t)_packet[at + 2] << 8 |
+             _packet[at + 3];
+    }
+    // Seconds since 1900 and a fraction in units of 2^-32 s. The seconds wrap every 136 years, in 2036 first: with
+    // the top bit set they count from 1900 (era 0), without it from that rollover (era 1), which covers 1968 to
+    // 2104 (RFC 4330, section 3)
+    constexpr uint64_t readTimestamp(uint8_t at) const {
+      return ((uint64_t)read32(at) + (read32(at) & 0x80000000 ? 0 : 0x100000000ULL) - SEVENZYYEARS) * 1000000 +
+             (((uint64_t)read32(at + 4) * 1000000) >> 32);
+    }
+    constexpr bool isZero(uint8_t at) const {
+      return read32(at) == 0 && read32(at + 4) == 0;
+    }
+    // 16.16 fixed-point seconds
+    constexpr unsigned long readShort(uint8_t at) const {
+      return ((uint64_t)read32(at) * 1000000) >> 16;
+    }
+
+    void write32(uint8_t at, uint32_t value) {
+      for (uint8_t i = 0; i < 4; i++) _packet[at + i] = value >> (24 - 8 * i);
+    }
+    // Rounded up, so readTimestamp() truncates it back to the same microsecond
+    static constexpr uint32_t fraction(uint64_t unixMicros) {
+      return (uint32_t)((((unixMicros % 1000000) << 32) + 999999) / 1000000);
+    }
+    // The era is left implied, the seconds are taken modulo 2^32
+    void writeTimestamp(uint8_t at, uint64_t unixMicros) {
+      write32(at, (uint32_t)(unixMicros / 1000000 + SEVENZYYEARS));
+      write32(at + 4, fraction(unixMicros));
+    }
+    void writeShort(uint8_t at, unsigned long us) {
+      write32(at, ((uint64_t)us << 16) / 1000000);
+    }
+
+  public:
+    constexpr explicit NTPPacket(byte* packet) : _packet(packet) {}
+
+    /**
+     * @return a four-letter ASCII code, as found in the reference ID of kiss-o'-death packets
+     */
+    static constexpr uint32_t code(const char* ascii) {
+      return (uint32_t)ascii[0] << 24 | (uint32_t)ascii[1] << 16 | (uint32_t)ascii[2] << 8 | (uint32_t)ascii[3];
+    }
+
+    constexpr uint8_t leap() const               { return _packet[0] >> 6; }
+    constexpr uint8_t version() const            { return (_packet[0] >> 3) & 0x07; }
+    constexpr uint8_t mode() const               { return _packet[0] & 0x07; }
+    constexpr uint8_t stratum() const            { return _packet[1]; }
+    constexpr int8_t  poll() const               { return (int8_t)_packet[2]; }
+    constexpr int8_t  precision() const          { return (int8_t)_packet[3]; }
+    constexpr unsigned long rootDelayMicros() const      { return readShort(4); }
+    constexpr unsigned long rootDispersionMicros() const { return readShort(8); }
+    constexpr uint32_t referenceId() const       { return read32(12); }
+    constexpr uint64_t referenceMicros() const   { return readTimestamp(16); }
+    constexpr uint64_t originateMicros() const   { return readTimestamp(24); }
+    constexpr uint64_t receiveMicros() const     { return readTimestamp(32); }
+    constexpr uint64_t transmitMicros() const    { return readTimestamp(40); }
+
+    /**
+     * Whether this answers the request we sent at transmitMicros: a reply echoes the request's transmit timestamp
+     * as its originate timestamp, bit for bit. Anything else is stale, a duplicate or spoofed.
+     */
+    bool isReplyTo(uint64_t transmitMicros) const {
+      uint64_t seconds = transmitMicros / 1000000 + SEVENZYYEARS;
+      return read32(24) == (uint32_t)seconds && read32(28) == fraction(transmitMicros);
+    }
+
+    /**
+     * Sanity checks of a server reply that do not depend on the request; see isReplyTo() for the rest.
+     */
+    NTPReplyStatus checkReply() const {
+      if (mode() != NTP_MODE_SERVER || version() < 1 || version() > 4) return NTP_REPLY_BAD_MODE;
+      if (stratum() == 0) return NTP_REPLY_KISS;
+      if (leap() == NTP_LEAP_UNSYNCHRONIZED || stratum() >= NTP_STRATUM_UNSYNCHRONIZED) {
+        return NTP_REPLY_UNSYNCHRONIZED;
+      }
+      // Zero as a whole is no timestamp; zero seconds alone is the first second of era 1
+      if (isZero(32) || isZero(40) || transmitMicros() < receiveMicros()) return NTP_REPLY_BAD_TIMESTAMPS;
+      return NTP_REPLY_OK;
+    }
+
+    /**
+     * Turn the buffer into a client request (version 4) sent at transmitMicros; the server hands that back as the
+     * originate timestamp.
+     */
+    void makeRequest(uint64_t transmitMicros) {
+      static const byte REQUEST[NTP_PACKET_SIZE] = {
+        0xE3, 0, 6, 0xEC,               // LI 3 (no time yet), version 4, mode 3; stratum; poll; precision
+        0, 0, 0, 0, 0, 0, 0, 0,         // Root delay and dispersion
+        49, 0x4E, 49, 52                // Reference ID
+      };
+      memcpy(_packet, REQUEST, NTP_PACKET_SIZE);
+      writeTimestamp(40, transmitMicros);
+    }
+
+    /**
+     * Turn a client request in the buffer into the header of its reply: mode 4, the request's version, poll
+     * interval and transmit timestamp (as originate timestamp) are kept, the rest is to be set.
+     */
+    void makeReply(uint8_t leap) {
+      _packet[0] = leap << 6 | version() << 3 | NTP_MODE_SERVER;
+      memcpy(_packet + 24, _packet + 40, 8);
+    }
+
+    void setStratum(uint8_t stratum)                 { _packet[1] = stratum; }
+    void setPrecision(int8_t precision)              { _packet[3] = (byte)precision; }
+    void setRootDelayMicros(unsigned long us)        { writeShort(4, us); }
+    void setRootDispersionMicros(unsigned long us)   { writeShort(8, us); }
+    void setReferenceId(uint32_t id)                 { write32(12, id); }
+    void setReferenceMicros(uint64_t unixMicros)     { writeTimestamp(16, unixMicros); }
+    void setReceiveMicros(uint64_t unixMicros)       { writeTimestamp(32, unixMicros); }
+    void setTransmitMicros(uint64_t unixMicros)      { writeTimestamp(40, unixMicros); }
+};
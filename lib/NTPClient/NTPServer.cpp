@@ -0,0 +1,83 @@
+#include "NTPServer.h"
+
+NTPServer::NTPServer(UDP& udp, NTPClient& clock) {
+  this->_udp   = &udp;
+  this->_clock = &clock;
+}
+
+void NTPServer::begin() {
+  this->begin(NTP_SERVER_PORT);
+}
+
+void NTPServer::begin(unsigned int port) {
+  this->_udp->begin(port);
+
+  this->_udpSetup = true;
+}
+
+uint16_t NTPServer::handle() {
+  if (!this->_udpSetup) return 0;
+
+  uint16_t answered = 0;
+  int size;
+  while ((size = this->_udp->parsePacket()) != 0) {
+    // T2, the arrival time, is read before anything else; the network stack may know it better
+    uint64_t now = monotonicMicros();
+    uint64_t arrived = this->_arrivalTime ? this->_arrivalTime() : 0;
+    if (arrived == 0 || arrived > now) arrived = now;
+    uint64_t received = this->_clock->getUtcMicrosAt(arrived);
+    this->_requests++;
+    if (size < NTP_PACKET_SIZE) {
+      this->_udp->flush();
+      continue;
+    }
+    this->_udp->read(this->_packetBuffer, NTP_PACKET_SIZE);
+    this->_udp->flush();
+
+    NTPPacket packet(this->_packetBuffer);
+    if (packet.mode() != NTP_MODE_CLIENT || packet.version() < 1 || packet.version() > 4) continue;
+
+    // The reply is built over the request
+    bool synced = this->_clock->isTimeSet();
+    IPAddress reference = this->_clock->getReferenceIP();
+    // A pending leap second is passed on, unless it is being smeared into the time served
+    uint8_t leap = this->_clock->getLeapSmear() ? NTP_LEAP_NONE : this->_clock->getLeapIndicator();
+    packet.makeReply(synced ? leap : NTP_LEAP_UNSYNCHRONIZED);
+    packet.setStratum(this->_clock->getStratum());
+    packet.setPrecision(NTP_SERVER_PRECISION);
+    packet.setRootDelayMicros(this->_clock->getRootDelayMicros());
+    packet.setRootDispersionMicros(this->_clock->getRootDispersionMicros());
+    packet.setReferenceId(synced ? (uint32_t)reference[0] << 24 | (uint32_t)reference[1] << 16 |
+                                   (uint32_t)reference[2] << 8 | reference[3] : 0);
+    packet.setReferenceMicros(this->_clock->getReferenceMicros());
+    packet.setReceiveMicros(received);
+
+    if (!this->_udp->beginPacket(this->_udp->remoteIP(), this->_udp->remotePort())) continue;
+    // T3 as late as the UDP API allows
+    packet.setTransmitMicros(this->_clock->getUtcMicros());
+    this->_udp->write(this->_packetBuffer, NTP_PACKET_SIZE);
+    if (this->_udp->endPacket()) {
+      this->_replies++;
+      answered++;
+    }
+  }
+  return answered;
+}
+
+void NTPServer::setArrivalTime(NTPArrivalTime arrivalTime) {
+  this->_arrivalTime = arrivalTime;
+}
+
+unsigned long NTPServer::getRequestCount() const {
+  return this->_requests;
+}
+
+unsigned long NTPServer::getReplyCount() const {
+  return this->_replies;
+}
+
+void NTPServer::end() {
+  this->_udp->stop();
+
+  this->_udpSetup = false;
+}
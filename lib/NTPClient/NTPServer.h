@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Arduino.h"
+
+#include <Udp.h>
+
+#include "NTPClient.h"
+
+#define NTP_SERVER_PORT 123
+#define NTP_SERVER_PRECISION -20                // log2 of the clock resolution in seconds, about 1 us
+
+/**
+ * SNTP server (RFC 4330) that hands out the time of an NTPClient, so one synchronized node can serve the rest of a
+ * network. Answers client (mode 3) requests with our stratum, the followed server as reference ID, its root delay and
+ * dispersion, and the receive and transmit timestamps read from the disciplined clock. While the client has no time
+ * yet the replies say so (leap indicator 3, stratum 16) and clients discard them.
+ *
+ * Requests are answered in place in one fixed buffer, nothing is allocated. The receive timestamp is taken when
+ * handle() picks the request up, so call it often: time a request waits before that counts as network delay. With
+ * setArrivalTime() it comes from the network stack instead, and handle() can run far less often.
+ */
+class NTPServer {
+  private:
+    UDP*          _udp;
+    NTPClient*    _clock;
+    bool          _udpSetup       = false;
+    NTPArrivalTime _arrivalTime   = NULL;
+
+    unsigned long _requests       = 0;
+    unsigned long _replies        = 0;
+
+    byte          _packetBuffer[NTP_PACKET_SIZE];
+
+  public:
+    NTPServer(UDP& udp, NTPClient& clock);
+
+    /**
+     * Starts listening on the NTP port, or on the given one
+     */
+    void begin();
+    void begin(unsigned int port);
+
+    /**
+     * Answer every request that has arrived, until the socket is empty; whatever is left waiting would be dropped by
+     * the network stack once its receive queue fills
+     *
+     * @return number of requests answered
+     */
+    uint16_t handle();
+
+    /**
+     * Take T2, the receive timestamp, from the time the network stack saw the request instead of the time handle()
+     * picks it up; the same hook as NTPClient::setArrivalTime(). A stamp of 0, or one later than handle(), is not
+     * used.
+     */
+    void setArrivalTime(NTPArrivalTime arrivalTime);
+
+    /**
+     * @return datagrams received so far, including those that were not valid requests
+     */
+    unsigned long getRequestCount() const;
+
+    /**
+     * @return replies sent so far
+     */
+    unsigned long getReplyCount() const;
+
+    /**
+     * Stops the underlying UDP client
+     */
+    void end();
+};
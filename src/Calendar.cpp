@@ -0,0 +1,59 @@
+#include "Calendar.h"
+
+#include <CivilDate.h>
+
+const struct tm* Calendar::at(int64_t time) {
+  if (_valid && time >= _time && time - _time < 86400) {
+    advance((long)(time - _time));
+  } else {
+    breakDown(time, _tm);
+    _valid = true;
+    _recomputes++;
+  }
+  _time = time;
+  return &_tm;
+}
+
+void Calendar::breakDown(int64_t time, struct tm& tm) {
+  int64_t days = (time >= 0 ? time : time - 86399) / 86400;
+  long seconds = (long)(time - days * 86400);
+  tm.tm_hour = seconds / 3600;
+  tm.tm_min = seconds / 60 % 60;
+  tm.tm_sec = seconds % 60;
+  tm.tm_wday = (int)((days % 7 + 11) % 7); // 1970-01-01 was a Thursday
+  tm.tm_isdst = 0;
+
+  long year;
+  uint8_t month, day;
+  tm.tm_yday = CivilDate::civilFromDays(days, year, month, day);
+  tm.tm_year = (int)(year - 1900);
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day;
+}
+
+void Calendar::advance(long seconds) {
+  long carry = _tm.tm_sec + seconds;
+  if (carry < 60) { // 59 times out of 60
+    _tm.tm_sec = carry;
+    return;
+  }
+  _tm.tm_sec = carry % 60;
+  carry = _tm.tm_min + carry / 60;
+  _tm.tm_min = carry % 60;
+  carry = _tm.tm_hour + carry / 60;
+  _tm.tm_hour = carry % 24;
+  for (carry /= 24; carry > 0; carry--) {
+    _tm.tm_wday = (_tm.tm_wday + 1) % 7;
+    _tm.tm_yday++;
+    if (++_tm.tm_mday <= CivilDate::daysInMonth(_tm.tm_year + 1900, _tm.tm_mon + 1)) {
+      continue;
+    }
+    _tm.tm_mday = 1;
+    if (++_tm.tm_mon < 12) {
+      continue;
+    }
+    _tm.tm_mon = 0;
+    _tm.tm_yday = 0;
+    _tm.tm_year++;
+  }
+}
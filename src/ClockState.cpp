@@ -0,0 +1,61 @@
+#include "ClockState.h"
+
+bool ClockState::restore(NTPClient& client) {
+  if (!_preferences.begin("clock", true)) {
+    return false;
+  }
+  bool valid = _preferences.getUChar("version") == VERSION &&
+               _preferences.getBytes("servers", _servers, sizeof(_servers)) == sizeof(_servers);
+  if (valid) {
+    _lastSync = _preferences.getULong64("sync");
+    client.setDriftPpm(_preferences.getDouble("drift", 0), _preferences.getDouble("driftError", DISCIPLINE_MAX_DRIFT));
+  }
+  _preferences.end();
+  if (!valid) {
+    return false;
+  }
+
+  client.setEstimatedTime(_lastSync);
+  for (uint8_t i = 0; i < client.getServerCount(); i++) {
+    IPAddress addresses[NTP_MAX_ADDRESSES];
+    uint8_t count = _servers[i].count < NTP_MAX_ADDRESSES ? _servers[i].count : NTP_MAX_ADDRESSES;
+    for (uint8_t j = 0; j < count; j++) {
+      const uint8_t* octets = _servers[i].addresses[j];
+      addresses[j] = IPAddress(octets[0], octets[1], octets[2], octets[3]);
+    }
+    client.setServerAddresses(i, addresses, count);
+  }
+  return true;
+}
+
+void ClockState::save(const NTPClient& client) {
+  SavedServer servers[NTP_MAX_SERVERS];
+  memset(servers, 0, sizeof(servers));
+  for (uint8_t i = 0; i < client.getServerCount(); i++) {
+    const NTPPeer& peer = client.getServer(i);
+    servers[i].count = peer.addressCount;
+    for (uint8_t j = 0; j < peer.addressCount; j++) {
+      for (uint8_t k = 0; k < 4; k++) {
+        servers[i].addresses[j][k] = peer.addresses[j][k];
+      }
+    }
+  }
+
+  if (!_preferences.begin("clock", false)) {
+    return;
+  }
+  _lastSync = client.getReferenceMicros();
+  _preferences.putULong64("sync", _lastSync);
+  _preferences.putDouble("drift", client.getDriftPpm());
+  _preferences.putDouble("driftError", client.getDriftErrorPpm());
+  if (memcmp(servers, _servers, sizeof(servers)) != 0 || _preferences.getUChar("version") != VERSION) {
+    memcpy(_servers, servers, sizeof(servers));
+    _preferences.putBytes("servers", _servers, sizeof(_servers));
+    _preferences.putUChar("version", VERSION);
+  }
+  _preferences.end();
+}
+
+uint64_t ClockState::lastSyncMicros() const {
+  return _lastSync;
+}
@@ -0,0 +1,136 @@
+#include "Metrics.h"
+
+#ifdef SIM_HOST
+#include <HostSim.h>
+
+namespace {
+
+const Metrics* hostMetrics = nullptr;
+
+void writeHostMetrics(Print& out) {
+  hostMetrics->printJson(out);
+}
+
+} // namespace
+#endif
+
+void Histogram::record(uint32_t value) {
+  uint8_t index = value ? 32 - __builtin_clz(value) : 0;
+  _buckets[index < BUCKETS ? index : BUCKETS - 1]++;
+  if (_count == 0 || value < _min) {
+    _min = value;
+  }
+  if (value > _max) {
+    _max = value;
+  }
+  _count++;
+  _sum += value;
+}
+
+uint32_t Histogram::percentile(uint8_t percent) const {
+  if (_count == 0) {
+    return 0;
+  }
+  uint32_t rank = ((uint64_t)_count * percent + 99) / 100; // The rank-th smallest value, from 1
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < BUCKETS - 1; i++) {
+    seen += _buckets[i];
+    if (seen >= rank) {
+      uint32_t top = i ? (1UL << i) - 1 : 0;
+      return constrain(top, _min, _max);
+    }
+  }
+  return _max;
+}
+
+Metrics::Metrics() {
+#ifdef SIM_HOST
+  hostMetrics = this;
+  sim::setMetricsWriter(writeHostMetrics);
+#endif
+}
+
+Counter& Metrics::counter(const char* name) {
+  if (_counterCount == MAX_COUNTERS) {
+    return _spareCounter;
+  }
+  _counterNames[_counterCount] = name;
+  return _counters[_counterCount++];
+}
+
+Histogram& Metrics::histogram(const char* name) {
+  if (_histogramCount == MAX_HISTOGRAMS) {
+    return _spareHistogram;
+  }
+  _histogramNames[_histogramCount] = name;
+  return _histograms[_histogramCount++];
+}
+
+void Metrics::printLines(Print& out) const {
+  out.print("metrics uptime_ms=");
+  out.println(millis());
+  for (uint8_t i = 0; i < _counterCount; i++) {
+    out.print(_counterNames[i]);
+    out.print(' ');
+    out.println(_counters[i].value());
+  }
+  for (uint8_t i = 0; i < _histogramCount; i++) {
+    const Histogram& histogram = _histograms[i];
+    out.print(_histogramNames[i]);
+    out.print(" n=");
+    out.print(histogram.count());
+    out.print(" min=");
+    out.print(histogram.lowest());
+    out.print(" p50=");
+    out.print(histogram.percentile(50));
+    out.print(" p90=");
+    out.print(histogram.percentile(90));
+    out.print(" p99=");
+    out.print(histogram.percentile(99));
+    out.print(" max=");
+    out.print(histogram.highest());
+    out.print(" mean=");
+    out.println(histogram.mean());
+  }
+}
+
+void Metrics::printJson(Print& out) const {
+  out.print("{\"uptime_ms\":");
+  out.print(millis());
+  out.print(",\"counters\":{");
+  for (uint8_t i = 0; i < _counterCount; i++) {
+    out.print(i ? ",\"" : "\"");
+    out.print(_counterNames[i]);
+    out.print("\":");
+    out.print(_counters[i].value());
+  }
+  out.print("},\"histograms\":{");
+  for (uint8_t i = 0; i < _histogramCount; i++) {
+    const Histogram& histogram = _histograms[i];
+    out.print(i ? ",\"" : "\"");
+    out.print(_histogramNames[i]);
+    out.print("\":{\"count\":");
+    out.print(histogram.count());
+    out.print(",\"min\":");
+    out.print(histogram.lowest());
+    out.print(",\"max\":");
+    out.print(histogram.highest());
+    out.print(",\"mean\":");
+    out.print(histogram.mean());
+    out.print(",\"p50\":");
+    out.print(histogram.percentile(50));
+    out.print(",\"p90\":");
+    out.print(histogram.percentile(90));
+    out.print(",\"p99\":");
+    out.print(histogram.percentile(99));
+    out.print(",\"buckets\":[");
+    for (uint8_t b = 0; b < Histogram::BUCKETS; b++) {
+      if (b) {
+        out.print(',');
+      }
+      out.print(histogram.bucket(b));
+    }
+    out.print("]}");
+  }
+  out.println("}}");
+}
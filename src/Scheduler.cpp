@@ -0,0 +1,58 @@
+#include "Scheduler.h"
+
+int8_t Scheduler::add(Callback callback) {
+  if (_count >= MAX_TASKS) {
+    return -1;
+  }
+  _tasks[_count] = {callback, 0, false};
+  return _count++;
+}
+
+void Scheduler::at(int8_t task, uint32_t dueMillis) {
+  _tasks[task].due = dueMillis;
+  _tasks[task].armed = true;
+}
+
+void Scheduler::in(int8_t task, unsigned long delayMillis) {
+  at(task, millis() + delayMillis);
+}
+
+void Scheduler::cancel(int8_t task) {
+  _tasks[task].armed = false;
+}
+
+void Scheduler::runDue() {
+  for (uint8_t i = 0; i < _count; i++) {
+    Task& task = _tasks[i];
+    if (task.armed && (int32_t)((uint32_t)millis() - task.due) >= 0) {
+      task.armed = false;
+      task.callback();
+    }
+  }
+}
+
+unsigned long Scheduler::millisToNext() const {
+  uint32_t now = millis();
+  unsigned long next = MAX_SLEEP;
+  for (uint8_t i = 0; i < _count; i++) {
+    const Task& task = _tasks[i];
+    if (!task.armed) {
+      continue;
+    }
+    int32_t remaining = (int32_t)(task.due - now);
+    if (remaining <= 0) {
+      return 0;
+    }
+    if ((unsigned long)remaining < next) {
+      next = remaining;
+    }
+  }
+  return next;
+}
+
+void Scheduler::sleepUntilNext() const {
+  unsigned long ms = millisToNext();
+  if (ms > 0) {
+    delay(ms);
+  }
+}
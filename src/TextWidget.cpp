@@ -0,0 +1,62 @@
+#include "TextWidget.h"
+
+// Scratch cell the glyph is rendered into before it is blitted. Shared by
+// all widgets; allocated once at startup.
+static GFXcanvas16 glyphCell(TextWidget::CELL_WIDTH, TextWidget::CELL_HEIGHT);
+
+uint32_t TextWidget::_cellsBlitted = 0;
+
+TextWidget::TextWidget(Adafruit_SPITFT& display, int16_t x, int16_t y, uint16_t color, uint16_t background)
+  : _display(display), _x(x), _y(y), _color(color), _background(background) {
+  forget();
+}
+
+void TextWidget::setText(const char* text) {
+  _text.clear();
+  _text.append(text);
+}
+
+void TextWidget::draw() {
+  sync(_text.c_str());
+}
+
+void TextWidget::hide() {
+  sync("");
+}
+
+void TextWidget::forget() {
+  memset(_cells, ' ', sizeof(_cells));
+}
+
+void TextWidget::sync(const char* text) {
+  unsigned long started = micros();
+  uint8_t blitted = 0;
+  // Only whole cells are drawn; text running off the edge is clipped there
+  int16_t visible = (_display.width() - _x) / CELL_WIDTH;
+  uint8_t cells = constrain(visible, (int16_t)0, (int16_t)MAX_CELLS);
+  size_t length = strlen(text);
+
+  for (uint8_t i = 0; i < cells; i++) {
+    char c = i < length ? text[i] : ' ';
+    if (c != _cells[i]) {
+      blitCell(i, c);
+      _cells[i] = c;
+      blitted++;
+    }
+  }
+  if (blitted) {
+    _cellsBlitted += blitted;
+    if (_renderMicros) {
+      _renderMicros->record(micros() - started);
+    }
+  }
+}
+
+void TextWidget::blitCell(uint8_t index, char c) {
+  glyphCell.drawChar(0, 0, c, _color, _background, 1);
+
+  _display.startWrite();
+  _display.setAddrWindow(_x + index * CELL_WIDTH, _y, CELL_WIDTH, CELL_HEIGHT);
+  _display.writePixels(glyphCell.getBuffer(), CELL_WIDTH * CELL_HEIGHT);
+  _display.endWrite();
+}
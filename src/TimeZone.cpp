@@ -0,0 +1,213 @@
+#include "TimeZone.h"
+
+#include <CivilDate.h>
+
+namespace {
+
+const long SECONDS_PER_DAY = 86400;
+
+long floorDiv(int64_t a, long b) {
+  return (long)(a >= 0 ? a / b : -((-a + b - 1) / b));
+}
+
+const char* parseNumber(const char* p, long& value, long max) {
+  if (*p < '0' || *p > '9') {
+    return NULL;
+  }
+  value = 0;
+  while (*p >= '0' && *p <= '9') {
+    value = value * 10 + (*p++ - '0');
+    if (value > max) {
+      return NULL;
+    }
+  }
+  return p;
+}
+
+} // namespace
+
+bool TimeZone::set(const char* rule) {
+  long stdOffset;
+  long dstOffset;
+  Rule start = {MONTH_WEEK, 3, 2, 0, 0, 7200}; // US rule: second Sunday in March
+  Rule end = {MONTH_WEEK, 11, 1, 0, 0, 7200};  // to first Sunday in November
+  bool hasDst = false;
+
+  const char* p = rule ? parseName(rule) : NULL;
+  if (!p || !(p = parseTime(p, stdOffset, 24))) {
+    return false;
+  }
+  stdOffset = -stdOffset; // POSIX counts west of UTC
+  dstOffset = stdOffset + 3600;
+  if (*p) {
+    if (!(p = parseName(p))) {
+      return false;
+    }
+    hasDst = true;
+    if (*p && *p != ',') {
+      if (!(p = parseTime(p, dstOffset, 24))) {
+        return false;
+      }
+      dstOffset = -dstOffset;
+    }
+    if (*p == ',') {
+      if (!(p = parseRule(p + 1, start)) || *p != ',' || !(p = parseRule(p + 1, end))) {
+        return false;
+      }
+    }
+    if (*p) {
+      return false;
+    }
+  }
+
+  _stdOffset = stdOffset;
+  _dstOffset = dstOffset;
+  _hasDst = hasDst;
+  _start = start;
+  _end = end;
+  _spanStart = 1;
+  _spanEnd = 0;
+  return true;
+}
+
+long TimeZone::offsetAt(int64_t utc) {
+  return isDstAt(utc) ? _dstOffset : _stdOffset;
+}
+
+bool TimeZone::isDstAt(int64_t utc) {
+  if (!_hasDst) {
+    return false;
+  }
+  if (utc < _spanStart || utc >= _spanEnd) {
+    findSpan(utc);
+  }
+  return _spanDst;
+}
+
+void TimeZone::findSpan(int64_t utc) {
+  // The transitions of the year before, this one and the next, in order.
+  // Of two at the same instant (all-year DST) the later listed one wins
+  long year;
+  uint8_t month, day;
+  CivilDate::civilFromDays(floorDiv(utc + _stdOffset, SECONDS_PER_DAY), year, month, day);
+  int64_t at[6];
+  bool dstAfter[6];
+  uint8_t count = 0;
+  for (long y = year - 1; y <= year + 1; y++) {
+    for (uint8_t k = 0; k < 2; k++) {
+      bool dst = k == 0;
+      int64_t instant = dst ? transition(y, _start, _stdOffset) : transition(y, _end, _dstOffset);
+      uint8_t i = count++;
+      for (; i > 0 && at[i - 1] > instant; i--) {
+        at[i] = at[i - 1];
+        dstAfter[i] = dstAfter[i - 1];
+      }
+      at[i] = instant;
+      dstAfter[i] = dst;
+    }
+  }
+
+  uint8_t i = 0;
+  while (i + 1 < count && at[i + 1] <= utc) {
+    i++;
+  }
+  _spanDst = dstAfter[i];
+  _spanStart = at[i];
+  _spanEnd = at[i + 1];
+}
+
+int64_t TimeZone::transition(int year, const Rule& rule, long offsetBefore) {
+  int64_t days;
+  switch (rule.kind) {
+    case JULIAN:
+      days = CivilDate::daysFromCivil(year, 1, 1) + rule.day - 1 + (CivilDate::isLeapYear(year) && rule.day >= 60);
+      break;
+    case ZERO_BASED:
+      days = CivilDate::daysFromCivil(year, 1, 1) + rule.day;
+      break;
+    default: {
+      int64_t first = CivilDate::daysFromCivil(year, rule.month, 1);
+      uint8_t firstWeekday = (uint8_t)(((first % 7) + 11) % 7); // 1970-01-01 was a Thursday
+      long day = (rule.weekday + 7 - firstWeekday) % 7 + (rule.week - 1) * 7;
+      while (day >= CivilDate::daysInMonth(year, rule.month)) {
+        day -= 7; // Week 5 means the last one
+      }
+      days = first + day;
+      break;
+    }
+  }
+  return days * SECONDS_PER_DAY + rule.time - offsetBefore;
+}
+
+const char* TimeZone::parseName(const char* p) {
+  const char* start = p;
+  if (*p == '<') {
+    while (*p && *p != '>') {
+      p++;
+    }
+    return *p && p - start >= 4 ? p + 1 : NULL;
+  }
+  while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) {
+    p++;
+  }
+  return p - start >= 3 ? p : NULL;
+}
+
+const char* TimeZone::parseTime(const char* p, long& seconds, long maxHours) {
+  bool negative = *p == '-';
+  if (*p == '+' || *p == '-') {
+    p++;
+  }
+  long hours;
+  long minutes = 0;
+  long secs = 0;
+  if (!(p = parseNumber(p, hours, maxHours))) {
+    return NULL;
+  }
+  if (*p == ':' && !(p = parseNumber(p + 1, minutes, 59))) {
+    return NULL;
+  }
+  if (*p == ':' && !(p = parseNumber(p + 1, secs, 59))) {
+    return NULL;
+  }
+  seconds = hours * 3600 + minutes * 60 + secs;
+  if (negative) {
+    seconds = -seconds;
+  }
+  return p;
+}
+
+const char* TimeZone::parseRule(const char* p, Rule& rule) {
+  long value;
+  rule.time = 7200;
+  if (*p == 'J') {
+    if (!(p = parseNumber(p + 1, value, 365)) || value < 1) {
+      return NULL;
+    }
+    rule.kind = JULIAN;
+    rule.day = value;
+  } else if (*p == 'M') {
+    long week;
+    long weekday;
+    if (!(p = parseNumber(p + 1, value, 12)) || value < 1 || *p != '.' ||
+        !(p = parseNumber(p + 1, week, 5)) || week < 1 || *p != '.' ||
+        !(p = parseNumber(p + 1, weekday, 6))) {
+      return NULL;
+    }
+    rule.kind = MONTH_WEEK;
+    rule.month = value;
+    rule.week = week;
+    rule.weekday = weekday;
+  } else {
+    if (!(p = parseNumber(p, value, 365))) {
+      return NULL;
+    }
+    rule.kind = ZERO_BASED;
+    rule.day = value;
+  }
+  // RFC 8536 extends the time of day to -167..167 hours
+  if (*p == '/' && !(p = parseTime(p + 1, rule.time, 167))) {
+    return NULL;
+  }
+  return p;
+}
@@ -0,0 +1,45 @@
+#include "WiFiLink.h"
+
+WiFiLink::WiFiLink(const char* ssid, const char* password) : _ssid(ssid), _password(password) {}
+
+unsigned long WiFiLink::run() {
+  wl_status_t status = WiFi.status();
+  switch (_state) {
+    case IDLE:
+      WiFi.begin(_ssid, _password);
+      _attemptStarted = millis();
+      _state = CONNECTING;
+      return CONNECT_POLL;
+
+    case CONNECTING:
+      if (status == WL_CONNECTED) {
+        _state = CONNECTED;
+        _backoff = MIN_BACKOFF;
+        _failures = 0;
+        return LINK_POLL;
+      }
+      if (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL ||
+          millis() - _attemptStarted >= CONNECT_TIMEOUT) {
+        return retryLater();
+      }
+      return CONNECT_POLL;
+
+    case CONNECTED:
+      if (status != WL_CONNECTED) {
+        WiFi.disconnect();
+        _state = IDLE;
+        return 0;
+      }
+      return LINK_POLL;
+  }
+  return LINK_POLL;
+}
+
+unsigned long WiFiLink::retryLater() {
+  WiFi.disconnect();
+  _state = IDLE;
+  _failures++;
+  unsigned long wait = _backoff + random(_backoff / 4 + 1);
+  _backoff = min(_backoff * 2, MAX_BACKOFF);
+  return wait;
+}
@@ -1,10 +1,22 @@
 #include <WiFi.h>
 #include <NTPClient.h>
+#include <NTPServer.h>
 #include <WiFiUdp.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1331.h>
 #include <SPI.h>
 #include <moonPhase.h>
+#include "Calendar.h"
+#include "ClockState.h"
+#include "Metrics.h"
+#include "Scheduler.h"
+#include "TextBuffer.h"
+#include "TextWidget.h"
+#include "TimeZone.h"
+#include "WiFiLink.h"
+#ifndef SIM_HOST
+#include <lwip/dns.h>
+#endif
 
 // Pin definitions
 #define SCLK 18
@@ -26,22 +38,68 @@ const char* ssid = "KooZoo";
 const char* password = "katrinzrk";
 
 // Objects and variables
+WiFiLink wifi(ssid, password);
 Adafruit_SSD1331 display = Adafruit_SSD1331(CS, DC, MOSI, SCLK, RST);
+// NTP sockets. The host's WiFiUDP takes arrival times from the kernel; the
+// core's cannot tell them
 WiFiUDP ntpUDP;
 NTPClient timeClient(ntpUDP);
-
-unsigned long lastSyncTime = 0;
-const unsigned long syncInterval = 600000; // Sync interval (10 minutes)
+WiFiUDP ntpServerUDP;
+NTPServer ntpServer(ntpServerUDP, timeClient); // Serves our time to the other clocks on the network
+ClockState clockState;
+TimeZone timeZone;
+Calendar calendar; // Date and time on the clock face, advanced tick by tick
+moonEphemeris moonTable; // Phase angle table the moon lines are looked up in
+
+Metrics metrics;
+Counter& ntpSyncs = metrics.counter("ntp.syncs");
+Counter& ntpFailures = metrics.counter("ntp.failures");
+Counter& wifiConnects = metrics.counter("wifi.connects");
+Histogram& ntpRtt = metrics.histogram("ntp.rtt_us");
+Histogram& ntpOffset = metrics.histogram("ntp.offset_us"); // How far off each sync found the clock
+Histogram& ntpPoll = metrics.histogram("ntp.poll_s"); // Wait after each sync until the next
+Histogram& frameBytes = metrics.histogram("spi.frame_bytes");
+
+// POSIX TZ rule of the local time: Eastern European Time, GMT+2 with summer time
+const char* timeZoneRule = "EET-2EEST,M3.5.0/3,M10.5.0/4";
+const unsigned long ntpRetryInterval = 64000; // Wait after a sync that failed or could not start; otherwise NTPClient sets the interval
+const unsigned long slideInterval = 10000; // Time each slide stays up
+const uint8_t ntpBurstSize = 4; // Requests per sync, the one with the quickest reply is used
+// Without arrival stamps the wait for these checks counts as network delay; a burst's quickest reply keeps it small
+const unsigned long ntpPollInterval = 10; // Reply check period while a request is outstanding
+const unsigned long ntpServeInterval = 100; // Request check period of the NTP server, which answers all waiting at once
+const unsigned long dnsCheckInterval = 100; // Answer check period while a DNS lookup is in progress
+const unsigned long moonRecheckInterval = 86400000; // Longest wait between full moon rechecks (1 day)
+const unsigned long metricsInterval = 60000; // Period of the metrics report on Serial
+// SPI bytes per blitted cell: its RGB565 pixels and the SSD1331 column and row address commands
+const uint16_t cellBytes = TextWidget::CELL_WIDTH * TextWidget::CELL_HEIGHT * 2 + 6;
 
 bool ntpSynced = false;
+bool clockSynced = false; // Set by the first successful sync since boot
+bool timeEstimated = false; // Showing the time saved before the last reboot, not synced yet
+bool networkStarted = false; // NTP sockets open, from the first Wi-Fi connection on
 bool redrawSlide1Required = false;
 bool slide2Drawn = false;
-
-String prevFormattedTime = "";
-String prevFormattedDate = "";
-String prevLastSync = "";
-String prevMoonIllumination = "";
-String prevNextFullMoon = "";
+bool slide1 = true;
+
+Scheduler scheduler;
+int8_t clockTask;
+int8_t slideTask;
+int8_t syncTask;
+int8_t ntpPollTask;
+int8_t resolveTask;
+int8_t serveTask;
+int8_t moonTask;
+int8_t wifiTask;
+int8_t metricsTask;
+
+// Slide 1
+TextWidget timeWidget(display, 0, 0, RED);
+TextWidget dateWidget(display, 0, 12, GREEN);
+TextWidget lastSyncWidget(display, 0, 24, LESS_BRIGHT_CYAN);
+// Slide 2
+TextWidget moonIlluminationWidget(display, 0, 36, YELLOW);
+TextWidget nextFullMoonWidget(display, 0, 48, PURPLE);
 
 const char* daysOfWeek[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
 
@@ -52,105 +110,267 @@ void initDisplay() {
   display.setTextWrap(false);
 }
 
-String formatTwoDigitNumber(int number) {
-  if (number < 10) {
-    return "0" + String(number);
+void formatLastSync(LineBuffer& line, const struct tm* timeStruct) {
+  line.clear();
+  line.append("NTP sync: ").appendTwoDigits(timeStruct->tm_hour).append(':').appendTwoDigits(timeStruct->tm_min);
+}
+
+void updateFormattedTime(const struct tm* timeStruct) {
+  LineBuffer formattedTime;
+  formattedTime.appendTwoDigits(timeStruct->tm_hour).append(':')
+               .appendTwoDigits(timeStruct->tm_min).append(':')
+               .appendTwoDigits(timeStruct->tm_sec);
+  timeWidget.setText(formattedTime.c_str());
+  timeWidget.draw();
+}
+
+void updateFormattedDate(const struct tm* timeStruct) {
+  LineBuffer formattedDate;
+  formattedDate.append(daysOfWeek[timeStruct->tm_wday]).append(' ')
+               .appendTwoDigits(timeStruct->tm_mday).append('/')
+               .appendTwoDigits(timeStruct->tm_mon + 1).append('/')
+               .appendUnsigned(timeStruct->tm_year + 1900);
+  dateWidget.setText(formattedDate.c_str());
+  dateWidget.draw();
+}
+
+void updateLastNTPSync(const struct tm* timeStruct) {
+  LineBuffer lastSync;
+  formatLastSync(lastSync, timeStruct);
+  lastSyncWidget.setText(lastSync.c_str());
+  lastSyncWidget.draw();
+}
+
+void updateMoonIllumination() {
+  int64_t currentTime = timeClient.getEpochTime(); // UTC, like the moon math
+  moonData_t moon = moonTable.getPhase(currentTime);
+  LineBuffer moonIllumination;
+  moonIllumination.append("Moon lit: ").appendFixed(moon.percentLit * 100, 2).append('%');
+
+  moonIlluminationWidget.setText(moonIllumination.c_str());
+  if (!slide1) {
+    moonIlluminationWidget.draw();
   }
-  return String(number);
-}
-
-void updateFormattedTime(struct tm* timeStruct) {
-  String formattedTime = formatTwoDigitNumber(timeStruct->tm_hour) + ":" + formatTwoDigitNumber(timeStruct->tm_min) + ":" + formatTwoDigitNumber(timeStruct->tm_sec);
-  if (formattedTime != prevFormattedTime) {
-    display.setTextColor(BLACK);
-    display.setCursor(0, 0);
-    display.print(prevFormattedTime);
-    display.setTextColor(RED);
-    display.setCursor(0, 0);
-    display.print(formattedTime);
-    prevFormattedTime = formattedTime;
+}
+
+/**
+   Find the next full moon and return the number of milliseconds until it,
+   which is when the result goes stale.
+*/
+unsigned long updateNextFullMoon() {
+  int64_t currentTime = timeClient.getEpochTime();
+  int64_t nextFullMoonTimestamp = moonTable.getNextFullMoon(currentTime);
+
+  struct tm nextFullMoonStruct;
+  Calendar::breakDown(timeZone.toLocal(nextFullMoonTimestamp), nextFullMoonStruct);
+  LineBuffer nextFullMoon;
+  nextFullMoon.append("Full moon: ").appendTwoDigits(nextFullMoonStruct.tm_mday).append('/')
+              .appendTwoDigits(nextFullMoonStruct.tm_mon + 1);
+
+  nextFullMoonWidget.setText(nextFullMoon.c_str());
+  if (!slide1) {
+    nextFullMoonWidget.draw();
   }
+
+  return (nextFullMoonTimestamp - currentTime) * 1000UL;
 }
 
-void updateFormattedDate(struct tm* timeStruct) {
-  String formattedDate = String(daysOfWeek[timeStruct->tm_wday]) + " " + formatTwoDigitNumber(timeStruct->tm_mday) + "/" + formatTwoDigitNumber(timeStruct->tm_mon + 1) + "/" + String(timeStruct->tm_year + 1900);
-  if (formattedDate != prevFormattedDate) {
-    display.setTextColor(BLACK);
-    display.setCursor(0, 12);
-    display.print(prevFormattedDate);
-    display.setTextColor(GREEN);
-    display.setCursor(0, 12);
-    display.print(formattedDate);
-    prevFormattedDate = formattedDate;
+/**
+   Delay until just past the next second edge. A millisecond late rather than
+   early: while the clock is being slewed its seconds run up to 0.5 ms shorter
+   or longer than millis() ones.
+*/
+unsigned long millisToNextSecond() {
+  return 1001 - timeClient.getMillisIntoSecond();
+}
+
+/**
+   Send an NTP request without waiting for it; pollNtp() picks up the reply
+   while the display keeps running. Without Wi-Fi there is nothing to send,
+   maintainWiFi() catches up once it is connected.
+*/
+void startNtpUpdate() {
+  if (wifi.isConnected() && timeClient.beginUpdate()) {
+    scheduler.in(ntpPollTask, ntpPollInterval);
   }
 }
 
-void updateLastNTPSync(struct tm* timeStruct) {
-  String lastSync = "NTP sync: " + formatTwoDigitNumber(timeStruct->tm_hour) + ":" + formatTwoDigitNumber(timeStruct->tm_min);
-  if (lastSync != prevLastSync) {
-    display.setTextColor(BLACK);
-    display.setCursor(0, 24);
-    display.print(prevLastSync);
-    display.setTextColor(LESS_BRIGHT_CYAN);
-    display.setCursor(0, 24);
-    display.print(lastSync);
-    prevLastSync = lastSync;
+#ifdef SIM_HOST
+/**
+   NTPClient arrival time: when the reply came in rather than when
+   pollNtp() got to it.
+*/
+uint64_t ntpArrivalTime() {
+  return ntpUDP.arrivalMicros();
+}
+
+/**
+   NTPServer arrival time: when the request came in rather than when
+   serveNtp() got to it.
+*/
+uint64_t ntpServerArrivalTime() {
+  return ntpServerUDP.arrivalMicros();
+}
+#endif
+
+void pollNtp() {
+  timeClient.poll();
+  if (timeClient.isUpdating()) {
+    scheduler.in(ntpPollTask, ntpPollInterval);
   }
 }
 
-void updateMoonIllumination() {
-  moonPhase moonPhaseInstance;
-  time_t currentTime = timeClient.getEpochTime(); // Get the current timestamp
-  moonData_t moon = moonPhaseInstance.getPhase(currentTime); // Pass the timestamp to the getPhase function
-  String moonIllumination = "Moon lit: " + String(moon.percentLit * 100, 2) + "%"; // Change the second argument to 2
-
-  if (moonIllumination != prevMoonIllumination) {
-    display.setTextColor(BLACK);
-    display.setCursor(0, 36);
-    display.print(prevMoonIllumination);
-    display.setTextColor(YELLOW);
-    display.setCursor(0, 36);
-    display.print(moonIllumination);
-    prevMoonIllumination = moonIllumination;
+#ifdef SIM_HOST
+/**
+   NTPClient resolver: the host's lookup, one address per call.
+*/
+uint8_t lookUpNtpServer(const char* host, IPAddress* addresses, uint8_t, unsigned long&) {
+  return WiFi.hostByName(host, addresses[0]) == 1 ? 1 : 0;
+}
+
+bool finishDnsLookups() {
+  return false; // The host's lookups answer at once
+}
+#else
+// Lookups lwIP is working on, one per server. Its callback fills in the
+// answer from lwIP's thread and the resolve task hands it to NTPClient
+struct DnsLookup {
+  const char* host; // NTPClient's copy of the name, nullptr when idle
+  uint32_t address; // 0 for no answer
+  volatile bool done;
+};
+DnsLookup dnsLookups[NTP_MAX_SERVERS] = {};
+
+void dnsLookupDone(const char*, const ip_addr_t* address, void* arg) {
+  DnsLookup* lookup = (DnsLookup*)arg;
+  lookup->address = address && IP_IS_V4(address) ? ip4_addr_get_u32(ip_2_ip4(address)) : 0;
+  lookup->done = true;
+}
+
+/**
+   NTPClient resolver, one address per call. The pool answers with a
+   different server each time, so the cache builds up a few to fail over to.
+   WiFi.hostByName() would wait for the DNS reply and stall the display.
+   This starts the lookup the same way, through dns_gethostbyname(), but
+   does not wait: an answer lwIP has cached comes back at once, any other
+   is handed in by finishDnsLookups().
+*/
+uint8_t lookUpNtpServer(const char* host, IPAddress* addresses, uint8_t, unsigned long&) {
+  DnsLookup* lookup = nullptr;
+  for (DnsLookup& slot : dnsLookups) {
+    if (slot.host == host) return 0; // Still waiting for the answer
+    if (!slot.host && !lookup) lookup = &slot;
   }
+  if (!lookup) return 0;
+  lookup->host = host;
+  lookup->done = false;
+  ip_addr_t address;
+  err_t result = dns_gethostbyname(host, &address, dnsLookupDone, lookup);
+  if (result == ERR_INPROGRESS) return 0;
+  lookup->host = nullptr;
+  if (result != ERR_OK || !IP_IS_V4(&address)) return 0;
+  addresses[0] = IPAddress(ip4_addr_get_u32(ip_2_ip4(&address)));
+  return 1;
 }
 
-void updateNextFullMoon() {
-  moonPhase moonPhaseInstance;
-  time_t currentTime = timeClient.getEpochTime();
-  time_t nextFullMoonTimestamp = currentTime;
+/**
+   Hand the answers of finished lookups to NTPClient.
+   @return true while some lookup is still waiting for its answer
+*/
+bool finishDnsLookups() {
+  bool waiting = false;
+  for (DnsLookup& lookup : dnsLookups) {
+    if (!lookup.host) continue;
+    if (!lookup.done) {
+      waiting = true;
+      continue;
+    }
+    for (uint8_t i = 0; i < timeClient.getServerCount() && lookup.address; i++) {
+      if (timeClient.getServer(i).name == lookup.host) {
+        IPAddress address(lookup.address);
+        timeClient.addServerAddresses(i, &address, 1);
+      }
+    }
+    lookup.host = nullptr;
+  }
+  return waiting;
+}
+#endif
 
-  while (true) {
-    moonData_t moonData = moonPhaseInstance.getPhase(nextFullMoonTimestamp);
-    if (moonData.percentLit >= 0.99) {
-      break;
+/**
+   Refresh the NTP server addresses as they expire, between syncs, so a sync
+   never waits on DNS.
+*/
+void resolveNtpServers() {
+  if (wifi.isConnected()) { // Otherwise rearmed on connecting
+    bool resolved = timeClient.getServer(0).addressCount > 0;
+    unsigned long next = timeClient.resolveServers() + 1;
+    bool waiting = finishDnsLookups();
+    scheduler.in(resolveTask, waiting && next > dnsCheckInterval ? dnsCheckInterval : next);
+    if (!resolved && timeClient.getServer(0).addressCount > 0 && !timeClient.isUpdating()) {
+      scheduler.in(syncTask, 0); // The sync on connecting had no address to ask yet
     }
-    nextFullMoonTimestamp += 86400; // Add one day (86400 seconds)
   }
+}
+
+void serveNtp() {
+  ntpServer.handle();
+  scheduler.in(serveTask, ntpServeInterval);
+}
 
-  struct tm* nextFullMoonStruct = localtime(&nextFullMoonTimestamp);
-  String nextFullMoon = "Full moon: " + formatTwoDigitNumber(nextFullMoonStruct->tm_mday) + "/" + formatTwoDigitNumber(nextFullMoonStruct->tm_mon + 1);
-
-  if (nextFullMoon != prevNextFullMoon) {
-    display.setTextColor(BLACK);
-    display.setCursor(0, 48);
-    display.print(prevNextFullMoon);
-    display.setTextColor(PURPLE);
-    display.setCursor(0, 48);
-    display.print(nextFullMoon);
-    prevNextFullMoon = nextFullMoon;
+/**
+   Completion callback for every NTP transaction.
+*/
+void onNtpUpdate(bool success) {
+  if (success) {
+    ntpSyncs.add();
+    ntpRtt.record(timeClient.getDelayMicros());
+    if (clockSynced) { // The first sync steps from no time or the estimate
+      int64_t offset = timeClient.getOffsetMicros();
+      ntpOffset.record(constrain(offset < 0 ? -offset : offset, (int64_t)0, (int64_t)UINT32_MAX));
+    }
+    ntpSynced = true; // Set the flag to true when NTP sync occurs
+    scheduler.in(clockTask, millisToNextSecond()); // The second edge may have moved
+    clockState.save(timeClient);
+    if (!clockSynced) {
+      clockSynced = true;
+      timeEstimated = false;
+      scheduler.in(moonTask, 0); // Not worked out yet, or from the estimate, which may be days behind
+    }
+    ntpPoll.record(timeClient.getUpdateInterval() / 1000);
+    scheduler.in(syncTask, timeClient.getUpdateInterval());
+  } else {
+    ntpFailures.add();
+    scheduler.in(syncTask, ntpRetryInterval);
   }
+  scheduler.in(resolveTask, 0); // A server that did not answer may need a fresh address
+}
+
+/**
+   NTPClient poll callback: log each change of the sync interval.
+*/
+void onNtpPoll(unsigned long interval, NTPPollReason reason) {
+  static const char* const reasons[] = { "kept", "clock stepped", "disturbed", "jitter", "stable", "reconnected" };
+  Serial.print("NTP interval ");
+  Serial.print(interval / 1000);
+  Serial.print(" s: ");
+  Serial.println(reasons[reason]);
 }
 
 /**
-   Update the clock display including time, date, last NTP sync, moon illumination,
-   and next full moon.
+   Update the clock display including time, date and last NTP sync.
 */
 void updateClock() {
-  timeClient.update();
+  if (!clockSynced && !timeEstimated) { // No time to show yet
+    timeWidget.setText("--:--:--");
+    timeWidget.draw();
+    dateWidget.setText(wifi.isConnected() ? "Syncing..."
+                       : wifi.state() == WiFiLink::CONNECTING ? "Wi-Fi..." : "No Wi-Fi");
+    dateWidget.draw();
+    return;
+  }
 
-  time_t currentTime = timeClient.getEpochTime();
-  struct tm* timeStruct = localtime(&currentTime);
+  const struct tm* timeStruct = calendar.at(timeZone.toLocal(timeClient.getEpochTime()));
 
   updateFormattedTime(timeStruct);
   updateFormattedDate(timeStruct);
@@ -158,31 +378,17 @@ void updateClock() {
     updateLastNTPSync(timeStruct);
     ntpSynced = false; // Reset the flag
   }
-
-  if (millis() - lastSyncTime > syncInterval) {
-    timeClient.forceUpdate();
-    currentTime = timeClient.getEpochTime();
-    timeStruct = localtime(&currentTime);
-    lastSyncTime = millis();
-    ntpSynced = true; // Set the flag to true when NTP sync occurs
-    updateNextFullMoon();
-  }
 }
 
 void displaySlide2() {
   if (!slide2Drawn) {
-    updateNextFullMoon();
-    updateMoonIllumination(); // Add this line to update the moon illumination information when slide 2 is displayed for the first time
-
-    display.fillScreen(BLACK);
+    updateMoonIllumination(); // Refresh illumination each time slide 2 comes up
 
-    display.setTextColor(YELLOW);
-    display.setCursor(0, 36);
-    display.print(prevMoonIllumination);
-
-    display.setTextColor(PURPLE);
-    display.setCursor(0, 48);
-    display.print(prevNextFullMoon);
+    timeWidget.hide();
+    dateWidget.hide();
+    lastSyncWidget.hide();
+    moonIlluminationWidget.draw();
+    nextFullMoonWidget.draw();
 
     slide2Drawn = true;
   }
@@ -190,83 +396,183 @@ void displaySlide2() {
 
 
 void redrawSlide1() {
-  display.fillScreen(BLACK);
-  display.setTextColor(RED);
-  display.setCursor(0, 0);
-  display.print(prevFormattedTime);
-
-  display.setTextColor(GREEN);
-  display.setCursor(0, 12);
-  display.print(prevFormattedDate);
-
-  display.setTextColor(LESS_BRIGHT_CYAN);
-  display.setCursor(0, 24);
-  display.print(prevLastSync);
+  moonIlluminationWidget.hide();
+  nextFullMoonWidget.hide();
+  timeWidget.draw();
+  dateWidget.draw();
+  lastSyncWidget.draw();
 
   redrawSlide1Required = false;
 }
 
 
 /**
-   Connect to Wi-Fi and set up initial state of the display.
+   Record what a frame that started with cellsBefore cells blitted cost on
+   the SPI bus, if it drew anything.
 */
-void setup() {
-  Serial.begin(115200);
+void recordFrame(uint32_t cellsBefore) {
+  uint32_t cells = TextWidget::cellsBlitted() - cellsBefore;
+  if (cells) {
+    frameBytes.record(cells * cellBytes);
+  }
+}
 
-  // Connect to Wi-Fi
-  Serial.print("Connecting to ");
-  Serial.println(ssid);
-  WiFi.begin(ssid, password);
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
+/**
+   Redraw the clock on the second edge and re-arm for the next one.
+*/
+void clockTick() {
+  uint32_t cellsBefore = TextWidget::cellsBlitted();
+  if (slide1) {
+    updateClock();
   }
-  Serial.println("");
-  Serial.println("WiFi connected");
+  recordFrame(cellsBefore);
+  scheduler.in(clockTask, millisToNextSecond());
+}
 
-  // Initialize display
-  initDisplay();
+void flipSlide() {
+  scheduler.in(slideTask, slideInterval);
+  if (!clockSynced && !timeEstimated) { // Nothing for slide 2 before there is a time
+    return;
+  }
+  uint32_t cellsBefore = TextWidget::cellsBlitted();
+  slide1 = !slide1;
+  if (slide1) {
+    redrawSlide1();
+    updateClock();
+  } else {
+    slide2Drawn = false;
+    displaySlide2();
+  }
+  recordFrame(cellsBefore);
+}
 
-  // Initialize time client
-  timeClient.begin();
-  timeClient.setTimeOffset(2 * 60 * 60); // Set time offset to GMT+2
+/**
+   Sync when NTPClient's adaptive interval is up. onNtpUpdate() rearms the
+   task for the next one; the retry here only runs if this sync does not
+   get that far.
+*/
+void resyncTime() {
+  startNtpUpdate();
+  scheduler.in(syncTask, ntpRetryInterval);
+}
 
-  // Force initial update and set prevLastSync
-  timeClient.forceUpdate();
-  time_t currentTime = timeClient.getEpochTime();
-  struct tm* timeStruct = localtime(&currentTime);
-  prevLastSync = "NTP sync: " + formatTwoDigitNumber(timeStruct->tm_hour) + ":" + formatTwoDigitNumber(timeStruct->tm_min);
+/**
+   The next full moon only changes once the current one has passed, so the
+   solver reruns just after that instant. The wait is capped at a day so an
+   NTP correction of the clock cannot leave the line stale for long.
+*/
+void recheckFullMoon() {
+  unsigned long untilFullMoon = updateNextFullMoon();
+  scheduler.in(moonTask, constrain(untilFullMoon + 1000, 1000UL, moonRecheckInterval));
+}
 
-  // Display the third line immediately after the first NTP sync
-  display.setTextColor(LESS_BRIGHT_CYAN);
-  display.setCursor(0, 24);
-  display.print(prevLastSync);
 
-  lastSyncTime = millis();
+void reportMetrics() {
+  metrics.printLines(Serial);
+  scheduler.in(metricsTask, metricsInterval);
 }
 
+
 /**
-   Updates the clock display at a regular 100ms interval.
+   Drive the Wi-Fi connection. On connecting, open the NTP sockets the first
+   time and shorten the sync interval again on later connects, then refresh
+   the server addresses and sync right away.
 */
-void loop() {
-  static unsigned long lastSlideChange = 0;
-  static bool slide1 = true;
-
-  if (millis() - lastSlideChange >= 10000) {
-    slide1 = !slide1;
-    lastSlideChange = millis();
-    if (slide1) {
-      redrawSlide1();
-    } else {
-      slide2Drawn = false;
-    }
+void maintainWiFi() {
+  bool wasConnected = wifi.isConnected();
+  scheduler.in(wifiTask, wifi.run());
+  if (!wifi.isConnected() || wasConnected) {
+    return;
   }
 
-  if (slide1) {
-    updateClock();
+  Serial.println("WiFi connected");
+  wifiConnects.add();
+  if (!networkStarted) {
+    timeClient.begin();
+    ntpServer.begin();
+    scheduler.in(serveTask, 0);
+    networkStarted = true;
   } else {
-    displaySlide2();
+    timeClient.restartPoll(); // Possibly another access point, with another path to the servers
+  }
+  scheduler.in(resolveTask, 0);
+  if (!timeClient.isUpdating()) {
+    scheduler.in(syncTask, 0);
+  }
+}
+
+
+/**
+   Set up the display and the tasks. Nothing waits for Wi-Fi: the clock
+   shows the time saved before the last reboot, if any, and syncs once
+   maintainWiFi() has connected.
+*/
+void setup() {
+  Serial.begin(115200);
+
+  // Initialize display
+  initDisplay();
+
+  timeZone.set(timeZoneRule);
+
+  // Time each widget takes to draw
+  timeWidget.setRenderTimes(&metrics.histogram("render.time_us"));
+  dateWidget.setRenderTimes(&metrics.histogram("render.date_us"));
+  lastSyncWidget.setRenderTimes(&metrics.histogram("render.last_sync_us"));
+  moonIlluminationWidget.setRenderTimes(&metrics.histogram("render.moon_lit_us"));
+  nextFullMoonWidget.setRenderTimes(&metrics.histogram("render.full_moon_us"));
+
+  // Initialize time client; its socket is opened once Wi-Fi is up
+  timeClient.setBurstSize(ntpBurstSize);
+  timeClient.addServer("1.pool.ntp.org"); // Three servers outvote one that is wrong
+  timeClient.addServer("2.pool.ntp.org");
+  timeClient.setResolver(lookUpNtpServer);
+#ifdef SIM_HOST
+  timeClient.setArrivalTime(ntpArrivalTime);
+  ntpServer.setArrivalTime(ntpServerArrivalTime);
+#endif
+
+  // Go on from the state saved before the last reboot until the first sync
+  timeEstimated = clockState.restore(timeClient);
+  if (timeEstimated) {
+    struct tm lastSyncStruct;
+    Calendar::breakDown(timeZone.toLocal(clockState.lastSyncMicros() / 1000000), lastSyncStruct);
+    updateLastNTPSync(&lastSyncStruct);
+  } else {
+    lastSyncWidget.setText("NTP sync: --:--");
+    lastSyncWidget.draw();
+  }
+
+  clockTask = scheduler.add(clockTick);
+  slideTask = scheduler.add(flipSlide);
+  syncTask = scheduler.add(resyncTime);
+  ntpPollTask = scheduler.add(pollNtp);
+  resolveTask = scheduler.add(resolveNtpServers);
+  serveTask = scheduler.add(serveNtp);
+  moonTask = scheduler.add(recheckFullMoon);
+  wifiTask = scheduler.add(maintainWiFi);
+  metricsTask = scheduler.add(reportMetrics);
+  timeClient.setUpdateCallback(onNtpUpdate);
+  timeClient.setPollCallback(onNtpPoll);
+
+  scheduler.in(clockTask, 0);
+  scheduler.in(slideTask, slideInterval);
+  if (timeEstimated) {
+    scheduler.in(moonTask, 0);
   }
-  
-  delay(100);
+  scheduler.in(metricsTask, metricsInterval);
+
+  Serial.print("Connecting to ");
+  Serial.println(ssid);
+  scheduler.in(wifiTask, 0);
+}
+
+/**
+   Runs whatever is due and sleeps until the next deadline: the next second
+   edge, slide flip, NTP resync, reply or request check, full moon recheck,
+   Wi-Fi check or metrics report.
+*/
+void loop() {
+  scheduler.runDue();
+  scheduler.sleepUntilNext();
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+/*
+  Host tests of the clock face calendar against the C library's
+  conversion, over month, year and leap-year ends, and what ticking it
+  forward saves. Run with `pio test -e native`.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "Calendar.h"
+
+static const int64_t DAY = 86400;
+
+void setUp() {}
+void tearDown() {}
+
+static void assertSameTime(const struct tm& expected, const struct tm& actual, int64_t time) {
+  char message[48];
+  snprintf(message, sizeof(message), "at %lld", (long long)time);
+  TEST_ASSERT_EQUAL_MESSAGE(expected.tm_year, actual.tm_year, message);
+  TEST_ASSERT_EQUAL_MESSAGE(expected.tm_mon, actual.tm_mon, message);
+  TEST_ASSERT_EQUAL_MESSAGE(expected.tm_mday, actual.tm_mday, message);
+  TEST_ASSERT_EQUAL_MESSAGE(expected.tm_hour, actual.tm_hour, message);
+  TEST_ASSERT_EQUAL_MESSAGE(expected.tm_min, actual.tm_min, message);
+  TEST_ASSERT_EQUAL_MESSAGE(expected.tm_sec, actual.tm_sec, message);
+  TEST_ASSERT_EQUAL_MESSAGE(expected.tm_wday, actual.tm_wday, message);
+  TEST_ASSERT_EQUAL_MESSAGE(expected.tm_yday, actual.tm_yday, message);
+}
+
+static void assertLikeGmtime(int64_t time) {
+  time_t t = (time_t)time;
+  struct tm expected, actual;
+  gmtime_r(&t, &expected);
+  Calendar::breakDown(time, actual);
+  assertSameTime(expected, actual, time);
+}
+
+/**
+   The last and first second of every day from 1900 to 2200, and a time
+   in between, convert like gmtime_r(): every month end, 29 February in
+   2000 and every fourth year, none in 1900 and 2100.
+*/
+void test_break_down_matches_gmtime() {
+  TEST_ASSERT_EQUAL(8, sizeof(time_t)); // The host's reference must reach past 2038
+  for (int64_t day = -25567; day < 84006; day++) {
+    assertLikeGmtime(day * DAY - 1);
+    assertLikeGmtime(day * DAY);
+    assertLikeGmtime(day * DAY + (day * 7919) % DAY);
+  }
+}
+
+/**
+   Ticking forward through every month end from 1999 to 2101 in steps of
+   a second up to hours carries into the date like a full conversion, and
+   without one.
+*/
+void test_ticking_matches_gmtime() {
+  static const long STEPS[] = {1, 1, 7, 59, 61, 1, 3599, 3600, 3601, 86399};
+  struct tm start = {};
+  for (int year = 1999; year <= 2101; year++) {
+    for (int month = 0; month < 12; month++) {
+      start.tm_year = month == 11 ? year + 1 - 1900 : year - 1900;
+      start.tm_mon = (month + 1) % 12;
+      start.tm_mday = 1;
+      int64_t midnight = (int64_t)timegm(&start); // After the last day of the month
+
+      Calendar calendar;
+      int64_t time = midnight - 2 * DAY;
+      calendar.at(time);
+      for (int i = 0; time < midnight + 2 * DAY; i++) {
+        time += STEPS[i % 10];
+        time_t t = (time_t)time;
+        struct tm expected;
+        gmtime_r(&t, &expected);
+        assertSameTime(expected, *calendar.at(time), time);
+      }
+      TEST_ASSERT_EQUAL(1, calendar.recomputes());
+    }
+  }
+}
+
+/**
+   Steps back and jumps of a day or more convert again in full.
+*/
+void test_steps_convert_again() {
+  Calendar calendar;
+  calendar.at(951782400); // 2000-02-29
+  calendar.at(951782400 + DAY - 1);
+  TEST_ASSERT_EQUAL(1, calendar.recomputes());
+  calendar.at(951782400 + 2 * DAY);
+  TEST_ASSERT_EQUAL(2, calendar.recomputes());
+  const struct tm* tm = calendar.at(951782400 - 1);
+  TEST_ASSERT_EQUAL(3, calendar.recomputes());
+  TEST_ASSERT_EQUAL(1, tm->tm_mon);
+  TEST_ASSERT_EQUAL(28, tm->tm_mday);
+  TEST_ASSERT_EQUAL(23, tm->tm_hour);
+}
+
+/**
+   Once a second for ten days across a year end: the calendar
+   ticking forward, its full conversion, gmtime_r() and localtime_r() with
+   the sketch's time zone, which the clock used to call. Reported only;
+   the incremental path has to beat the C library.
+*/
+void test_tick_throughput() {
+  static const int64_t START = 1703894400; // 2023-12-30, so the ticks cross a year end
+  static const long TICKS = 10 * DAY;
+  volatile long sink = 0;
+
+  Calendar calendar;
+  unsigned long start = micros();
+  for (long i = 0; i < TICKS; i++) sink = sink + calendar.at(START + i)->tm_mday;
+  unsigned long ticking = micros() - start;
+
+  struct tm tm;
+  start = micros();
+  for (long i = 0; i < TICKS; i++) {
+    Calendar::breakDown(START + i, tm);
+    sink = sink + tm.tm_mday;
+  }
+  unsigned long full = micros() - start;
+
+  start = micros();
+  for (long i = 0; i < TICKS; i++) {
+    time_t t = (time_t)(START + i);
+    gmtime_r(&t, &tm);
+    sink = sink + tm.tm_mday;
+  }
+  unsigned long gmtime = micros() - start;
+
+  setenv("TZ", "EET-2EEST,M3.5.0/3,M10.5.0/4", 1);
+  tzset();
+  start = micros();
+  for (long i = 0; i < TICKS; i++) {
+    time_t t = (time_t)(START + i);
+    localtime_r(&t, &tm);
+    sink = sink + tm.tm_mday;
+  }
+  unsigned long localtime = micros() - start;
+
+  char line[160];
+  snprintf(line, sizeof(line), "ns per second ticked: Calendar::at %lu, breakDown %lu, gmtime_r %lu, localtime_r %lu",
+           (unsigned long)(ticking * 1000 / TICKS), (unsigned long)(full * 1000 / TICKS),
+           (unsigned long)(gmtime * 1000 / TICKS), (unsigned long)(localtime * 1000 / TICKS));
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_THAN(gmtime, ticking);
+  TEST_ASSERT_EQUAL(1, calendar.recomputes());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_break_down_matches_gmtime);
+  RUN_TEST(test_ticking_matches_gmtime);
+  RUN_TEST(test_steps_convert_again);
+  RUN_TEST(test_tick_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,89 @@
+/*
+  Host tests of the interpolated moon ephemeris against the full
+  calculation in moonPhase: run with `pio test -e native`.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <moonPhase.h>
+
+static const int64_t DAY = 86400;
+static const int64_t START = 1672531200; // 2023-01-01 00:00 UTC
+
+// The class comment promises the angle within 2e-5 degrees, which moves
+// the lit fraction (1 - cos angle) / 2 by at most sin(angle) / 2 times that
+static const double MAX_LIT_ERROR = 2e-5 * PI / 180 / 2;
+
+static moonPhase moon;
+static uint32_t seed = 2024;
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t nextRandom() {
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+/**
+   @return how many of the angles were a degree off: only where the true
+   angle is within the error bound of a whole degree, so hardly ever
+*/
+static int comparePhase(moonEphemeris& table, int64_t t) {
+  moonData_t expected = moon.getPhase(t);
+  moonData_t actual = table.getPhase(t);
+  TEST_ASSERT_TRUE(fabs(expected.percentLit - actual.percentLit) <= MAX_LIT_ERROR);
+  int32_t off = (actual.angle - expected.angle + 360) % 360;
+  TEST_ASSERT_TRUE(off == 0 || off == 1 || off == 359);
+  return off != 0;
+}
+
+/**
+   As the clock asks: every minute for two months, as the table moves on.
+*/
+void test_phase_while_time_goes_on() {
+  moonEphemeris table;
+  int offByOne = 0;
+  for (int64_t t = START; t < START + 60 * DAY; t += 60) offByOne += comparePhase(table, t);
+  TEST_ASSERT_LESS_THAN(20, offByOne);
+}
+
+/**
+   Anywhere from 1970 to 2100 in random order: the table moves to each
+   instant or, far from it, falls back to the full calculation.
+*/
+void test_phase_at_random_instants() {
+  moonEphemeris table;
+  int offByOne = 0;
+  for (int i = 0; i < 20000; i++) {
+    int64_t t = (int64_t)(((uint64_t)nextRandom() << 32 | nextRandom()) % (uint64_t)(130 * 365 * DAY));
+    offByOne += comparePhase(table, t);
+    offByOne += comparePhase(table, t + nextRandom() % (30 * DAY)); // Near it, mostly within the table
+  }
+  TEST_ASSERT_LESS_THAN(20, offByOne);
+}
+
+/**
+   Each quarter the solver finds for the next three years is the one the
+   full calculation finds, to the second.
+*/
+void test_next_phases_match() {
+  moonEphemeris table;
+  for (int64_t t = START; t < START + 3 * 365 * DAY; t += DAY / 3 + 17) {
+    for (int angle = 0; angle < 360; angle += 90) {
+      int64_t expected = moon.getNextPhase(t, angle);
+      int64_t actual = table.getNextPhase(t, angle);
+      TEST_ASSERT_INT64_WITHIN(1, expected, actual);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_phase_while_time_goes_on);
+  RUN_TEST(test_phase_at_random_instants);
+  RUN_TEST(test_next_phases_match);
+  return UNITY_END();
+}
@@ -0,0 +1,109 @@
+/*
+  Host tests of the moon phase solver: run with `pio test -e native`.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <moonPhase.h>
+
+static const int64_t DAY = 86400;
+static const int64_t START = 1672531200; // 2023-01-01 00:00 UTC
+
+static moonPhase moon;
+
+void setUp() {}
+void tearDown() {}
+
+/**
+   Every full moon found is the instant the lit fraction peaks: ten minutes
+   either side it is smaller, and it is never more than a synodic month out.
+*/
+void test_full_moon_is_illumination_maximum() {
+  for (int64_t t = START; t < START + 3 * 365 * DAY; t += 5 * DAY + 37) {
+    int64_t full = moon.getNextFullMoon(t);
+    TEST_ASSERT_GREATER_THAN(t, full);
+    TEST_ASSERT_LESS_THAN(t + 30 * DAY, full);
+    double lit = moon.getPhase(full).percentLit;
+    TEST_ASSERT_TRUE(lit > moon.getPhase(full - 600).percentLit);
+    TEST_ASSERT_TRUE(lit > moon.getPhase(full + 600).percentLit);
+    TEST_ASSERT_TRUE(lit > 0.999);
+  }
+}
+
+void test_quarters_reach_their_angle() {
+  for (int64_t t = START; t < START + 365 * DAY; t += 3 * DAY + 1234) {
+    int32_t angle = moon.getPhase(moon.getNextFirstQuarter(t)).angle;
+    TEST_ASSERT_TRUE(angle == 89 || angle == 90);
+    angle = moon.getPhase(moon.getNextLastQuarter(t)).angle;
+    TEST_ASSERT_TRUE(angle == 269 || angle == 270);
+    double lit = moon.getPhase(moon.getNextNewMoon(t)).percentLit;
+    TEST_ASSERT_TRUE(lit < 0.001);
+  }
+}
+
+/**
+   Asked at a full moon, the solver moves on to the next one.
+*/
+void test_next_phase_is_strictly_after() {
+  int64_t full = moon.getNextFullMoon(START);
+  int64_t next = moon.getNextFullMoon(full);
+  TEST_ASSERT_INT64_WITHIN(DAY, (int64_t)(29.53 * DAY), next - full);
+  TEST_ASSERT_EQUAL_INT64(next, moon.getNextFullMoon(full + 1));
+}
+
+/**
+   The search the sketch ran before the solver: whole days from t until
+   the moon is at least 99% lit. @return that day, and in steps how many
+   getPhase() calls it took
+*/
+static int64_t steppedFullMoon(int64_t t, long& steps) {
+  while (moon.getPhase(t).percentLit < 0.99) {
+    t += DAY;
+    steps++;
+  }
+  steps++;
+  return t;
+}
+
+/**
+   The solver against the day-stepping loop from 2000 start times on. The
+   moon stays 99% lit for about a day either side of full, so the loop
+   stops anywhere in that window, possibly past the full moon; the solver
+   has to be the faster of the two. Timings are reported only.
+*/
+void test_search_throughput() {
+  static const int SEARCHES = 2000;
+  static const int64_t STEP = 7 * 3600 + 1234; // Spreads the start times over the synodic month
+  volatile int64_t sink = 0;
+
+  long steps = 0;
+  unsigned long start = micros();
+  for (int i = 0; i < SEARCHES; i++) sink = sink + steppedFullMoon(START + i * STEP, steps);
+  unsigned long stepped = micros() - start;
+
+  start = micros();
+  for (int i = 0; i < SEARCHES; i++) sink = sink + moon.getNextFullMoon(START + i * STEP);
+  unsigned long solved = micros() - start;
+
+  for (int i = 0; i < SEARCHES; i++) {
+    long ignored = 0;
+    int64_t found = steppedFullMoon(START + i * STEP, ignored);
+    TEST_ASSERT_INT64_WITHIN(DAY + DAY / 10, moon.getNextFullMoon(found - 2 * DAY), found);
+  }
+
+  char line[160];
+  snprintf(line, sizeof(line), "%d searches: day stepping %lu ns each (%lu.%02lu getPhase() calls), solver %lu ns each",
+           SEARCHES, (unsigned long)((uint64_t)stepped * 1000 / SEARCHES), steps / SEARCHES,
+           steps * 100 / SEARCHES % 100, (unsigned long)((uint64_t)solved * 1000 / SEARCHES));
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_THAN(stepped, solved);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_moon_is_illumination_maximum);
+  RUN_TEST(test_quarters_reach_their_angle);
+  RUN_TEST(test_next_phase_is_strictly_after);
+  RUN_TEST(test_search_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,160 @@
+/*
+  Host tests of time past 32 bits: NTP timestamps across the 2036 wrap of
+  their seconds, the calendar past 2038, and the client syncing across
+  both in virtual time.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <time.h>
+
+#include <FakeNtpServer.h>
+#include <HostSim.h>
+#include <NTPClient.h>
+#include <WiFiUdp.h>
+
+#include "Calendar.h"
+
+static const uint64_t NTP_WRAP = 2085978496; // 2036-02-07 06:28:16 UTC, NTP seconds 2^32
+static const uint64_t TIME_T_WRAP = 2147483648; // 2038-01-19 03:14:08 UTC, 32-bit time_t 2^31
+static const uint64_t SECOND = 1000000;
+
+static FakeNtpServer server;
+static WiFiUDP udp;
+
+void setUp() {}
+void tearDown() {}
+
+static void setSeconds(byte* buffer, uint8_t at, uint32_t seconds, uint32_t fraction) {
+  for (uint8_t i = 0; i < 4; i++) {
+    buffer[at + i] = seconds >> (24 - 8 * i);
+    buffer[at + 4 + i] = fraction >> (24 - 8 * i);
+  }
+}
+
+/**
+   Seconds with the top bit set count from 1900, without it from the 2036
+   wrap, which covers 1968 to 2104.
+*/
+void test_timestamp_eras() {
+  byte buffer[NTP_PACKET_SIZE] = {};
+  NTPPacket packet(buffer);
+
+  setSeconds(buffer, 40, 0xE8FE6F80, 0x80000000); // 2023-11-14 22:13:20.5, era 0
+  TEST_ASSERT_EQUAL_UINT64(1700000000 * SECOND + 500000, packet.transmitMicros());
+  setSeconds(buffer, 40, 0xFFFFFFFF, 0xFFFFFFFF); // The last moment of era 0
+  TEST_ASSERT_EQUAL_UINT64(NTP_WRAP * SECOND - 1, packet.transmitMicros());
+  setSeconds(buffer, 40, 0x00000000, 0x00000000); // The first of era 1
+  TEST_ASSERT_EQUAL_UINT64(NTP_WRAP * SECOND, packet.transmitMicros());
+  setSeconds(buffer, 40, 0x03AA7E7F, 0); // 2038-01-19 03:14:07, the last second of a 32-bit time_t
+  TEST_ASSERT_EQUAL_UINT64((TIME_T_WRAP - 1) * SECOND, packet.transmitMicros());
+  setSeconds(buffer, 40, 0x7FFFFFFF, 0); // 2104-02-26 09:42:23, where era 1 hands back to era 0
+  TEST_ASSERT_EQUAL_UINT64((NTP_WRAP + 0x7FFFFFFF) * SECOND, packet.transmitMicros());
+
+  // Written with the era left implied, read back into the right one
+  packet.setTransmitMicros(NTP_WRAP * SECOND + 250000);
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)buffer[40] << 24 | buffer[41] << 16 | buffer[42] << 8 | buffer[43]);
+  TEST_ASSERT_EQUAL_UINT64(NTP_WRAP * SECOND + 250000, packet.transmitMicros());
+  packet.setTransmitMicros(TIME_T_WRAP * SECOND + 3);
+  TEST_ASSERT_EQUAL_UINT64(TIME_T_WRAP * SECOND + 3, packet.transmitMicros());
+}
+
+/**
+   A reply received just before the wrap and sent just after it is in
+   order; the other way round it is not.
+*/
+void test_reply_straddling_the_wrap() {
+  byte buffer[NTP_PACKET_SIZE] = {};
+  NTPPacket packet(buffer);
+  buffer[0] = 4 << 3 | NTP_MODE_SERVER;
+  buffer[1] = 2;
+  setSeconds(buffer, 32, 0xFFFFFFFF, 0xF0000000);
+  setSeconds(buffer, 40, 0x00000000, 0x10000000);
+  TEST_ASSERT_EQUAL(NTP_REPLY_OK, packet.checkReply());
+  TEST_ASSERT_EQUAL_UINT64(125000, packet.transmitMicros() - packet.receiveMicros());
+
+  setSeconds(buffer, 32, 0x00000000, 0x10000000);
+  setSeconds(buffer, 40, 0xFFFFFFFF, 0xF0000000);
+  TEST_ASSERT_EQUAL(NTP_REPLY_BAD_TIMESTAMPS, packet.checkReply());
+}
+
+/**
+   Every second for a minute either side of both wraps, and of 2106 where
+   32 unsigned bits end, converts like the host's 64-bit gmtime_r().
+*/
+void test_calendar_past_2038() {
+  TEST_ASSERT_EQUAL(8, sizeof(time_t));
+  const int64_t wraps[] = {(int64_t)NTP_WRAP, (int64_t)TIME_T_WRAP, 4294967296LL};
+  for (int64_t wrap : wraps) {
+    for (int64_t time = wrap - 60; time <= wrap + 60; time++) {
+      time_t t = (time_t)time;
+      struct tm expected, actual;
+      gmtime_r(&t, &expected);
+      Calendar::breakDown(time, actual);
+      TEST_ASSERT_EQUAL(expected.tm_year, actual.tm_year);
+      TEST_ASSERT_EQUAL(expected.tm_yday, actual.tm_yday);
+      TEST_ASSERT_EQUAL(expected.tm_mon, actual.tm_mon);
+      TEST_ASSERT_EQUAL(expected.tm_mday, actual.tm_mday);
+      TEST_ASSERT_EQUAL(expected.tm_wday, actual.tm_wday);
+      TEST_ASSERT_EQUAL(expected.tm_hour * 3600 + expected.tm_min * 60 + expected.tm_sec,
+                        actual.tm_hour * 3600 + actual.tm_min * 60 + actual.tm_sec);
+    }
+  }
+
+  // Ticking forward across the 2038 wrap
+  Calendar calendar;
+  for (int64_t time = TIME_T_WRAP - 2; time <= (int64_t)TIME_T_WRAP + 1; time++) calendar.at(time);
+  const struct tm* tm = calendar.at(TIME_T_WRAP);
+  TEST_ASSERT_EQUAL(138, tm->tm_year);
+  TEST_ASSERT_EQUAL(0, tm->tm_mon);
+  TEST_ASSERT_EQUAL(19, tm->tm_mday);
+  TEST_ASSERT_EQUAL(3, tm->tm_hour);
+  TEST_ASSERT_EQUAL(14, tm->tm_min);
+  TEST_ASSERT_EQUAL(8, tm->tm_sec);
+}
+
+/**
+   The client syncs a minute before the wrap, keeps time across it and
+   syncs again on the other side, against the fake server's era-less
+   timestamps.
+*/
+static void syncAcross(uint64_t wrap) {
+  sim::setEpochMicros((wrap - 60) * SECOND - sim::elapsedMicros());
+  NTPClient client(udp);
+  client.begin();
+  for (int i = 0; i < 2; i++) {
+    TEST_ASSERT_TRUE(client.beginUpdate());
+    while (client.isUpdating()) {
+      client.poll();
+      sim::advance(1000);
+    }
+    TEST_ASSERT_TRUE(client.isTimeSet());
+    TEST_ASSERT_INT64_WITHIN(1000, (int64_t)sim::utcMicros(), (int64_t)client.getUtcMicros());
+    TEST_ASSERT_EQUAL_UINT64(sim::utcMicros() / SECOND, client.getEpochTime());
+    sim::advance(90 * SECOND);
+    TEST_ASSERT_INT64_WITHIN(1000, (int64_t)sim::utcMicros(), (int64_t)client.getUtcMicros());
+  }
+  TEST_ASSERT_GREATER_THAN(wrap, client.getEpochTime());
+  client.end();
+}
+
+void test_client_across_2036() {
+  syncAcross(NTP_WRAP);
+}
+
+void test_client_across_2038() {
+  syncAcross(TIME_T_WRAP);
+}
+
+int main() {
+  sim::setVirtualTime(true);
+  sim::setEpoch(NTP_WRAP);
+  sim::addRoute(nullptr, 123, server.begin());
+  UNITY_BEGIN();
+  RUN_TEST(test_timestamp_eras);
+  RUN_TEST(test_reply_straddling_the_wrap);
+  RUN_TEST(test_calendar_past_2038);
+  RUN_TEST(test_client_across_2036);
+  RUN_TEST(test_client_across_2038);
+  return UNITY_END();
+}
@@ -0,0 +1,91 @@
+/*
+  Host test of a long outage in virtual time: a day of syncs, then 120
+  days without another while millis() wraps around three times, on a
+  crystal that runs 25 ppm fast.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <FakeNtpServer.h>
+#include <HostSim.h>
+#include <NTPClient.h>
+#include <WiFiUdp.h>
+
+static const uint64_t SECOND = 1000000;
+static const uint64_t DAY = 86400 * SECOND;
+static const double DRIFT_PPM = 25;
+
+static FakeNtpServer server;
+static WiFiUDP udp;
+static NTPClient client(udp);
+
+void setUp() {}
+void tearDown() {}
+
+static void sync() {
+  TEST_ASSERT_TRUE(client.beginUpdate());
+  while (client.isUpdating()) {
+    client.poll();
+    sim::advance(1000);
+  }
+  TEST_ASSERT_TRUE(client.isTimeSet());
+}
+
+/**
+   A day of regular syncs teaches the client the drift; it ends an hour
+   short of the millis() wrap. Then no update for 120 days: the clock
+   drifts off by no more than the drift estimate is off, a part per
+   billion, and never jumps. The time since the last update is never cut
+   down to 32 bits, which put it 49.7 days behind.
+*/
+void test_holds_time_for_120_days() {
+  sync();
+  for (uint64_t start = sim::elapsedMicros(); sim::elapsedMicros() - start < DAY;) {
+    sim::advance((uint64_t)client.getUpdateInterval() * 1000);
+    sync();
+  }
+  TEST_ASSERT_TRUE(fabs(client.getDriftPpm() - DRIFT_PPM) < 0.01);
+
+  int wraps = 0;
+  unsigned long lastMillis = millis();
+  int64_t lastError = (int64_t)client.getUtcMicros() - (int64_t)sim::utcMicros();
+  for (int day = 1; day <= 120; day++) {
+    for (int hour = 0; hour < 24; hour++) {
+      sim::advance(DAY / 24);
+      if (millis() < lastMillis) wraps++;
+      lastMillis = millis();
+    }
+    TEST_ASSERT_TRUE(client.isTimeSet());
+    int64_t error = (int64_t)client.getUtcMicros() - (int64_t)sim::utcMicros();
+    TEST_ASSERT_INT64_WITHIN(1000 + day * 86, 0, error); // 1 ms and 1 ppb
+    TEST_ASSERT_INT64_WITHIN(100, lastError, error);
+    lastError = error;
+  }
+  TEST_ASSERT_EQUAL(3, wraps); // An hour in, at 50.7 and at 100.4 days
+}
+
+/**
+   Long overdue, the next update is due, measures how far the clock got
+   off and slews that out within seconds.
+*/
+void test_resyncs_after_120_days() {
+  TEST_ASSERT_TRUE(client.isUpdateDue());
+  int64_t error = (int64_t)client.getUtcMicros() - (int64_t)sim::utcMicros();
+  sync();
+  TEST_ASSERT_INT64_WITHIN(100, -error, client.getOffsetMicros());
+  sim::advance(30 * SECOND); // 500 ppm slews out 15 ms
+  TEST_ASSERT_INT64_WITHIN(100, (int64_t)sim::utcMicros(), (int64_t)client.getUtcMicros());
+}
+
+int main() {
+  sim::setVirtualTime(true);
+  sim::setEpoch(1760000000);
+  sim::setUptimeMicros(((uint64_t)1 << 32) * 1000 - DAY - 3600 * SECOND);
+  sim::setDriftPpm(DRIFT_PPM);
+  sim::addRoute(nullptr, 123, server.begin());
+  client.begin();
+  UNITY_BEGIN();
+  RUN_TEST(test_holds_time_for_120_days);
+  RUN_TEST(test_resyncs_after_120_days);
+  return UNITY_END();
+}
@@ -0,0 +1,143 @@
+/*
+  Host tests of leap seconds in virtual time: the fake server announces
+  one on 31 December 2016, the client syncs an hour before midnight and
+  its clock is read through the leap, stepped like POSIX time or smeared.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <FakeNtpServer.h>
+#include <HostSim.h>
+#include <NTPClient.h>
+#include <WiFiUdp.h>
+
+static const uint64_t LEAP = 1483228800; // 2017-01-01 00:00 UTC
+static const uint64_t SECOND = 1000000;
+
+static FakeNtpServer server;
+static WiFiUDP udp;
+static NTPClient* client;
+
+/**
+   Jump to this many µs of POSIX time before the leap midnight, which is
+   also the device's uniform time then.
+*/
+static void startBefore(uint64_t before) {
+  sim::setEpochMicros(LEAP * SECOND - before - sim::elapsedMicros());
+}
+
+/**
+   @return µs of uniform time since the leap midnight, negative before it:
+   unlike POSIX time it neither repeats nor skips a second
+*/
+static int64_t sinceMidnight() {
+  return (int64_t)sim::elapsedMicros() - (int64_t)(LEAP * SECOND - sim::utcMicrosAt(0));
+}
+
+static void sync() {
+  TEST_ASSERT_TRUE(client->beginUpdate());
+  while (client->isUpdating()) {
+    client->poll();
+    sim::advance(1000);
+  }
+  TEST_ASSERT_TRUE(client->isTimeSet());
+}
+
+void setUp() {
+  client = new NTPClient(udp);
+  client->begin();
+}
+
+void tearDown() {
+  client->end();
+  delete client;
+  sim::setLeapSecond(0, 0);
+}
+
+/**
+   Reads the clock every 250 ms from 3 s before to 3 s after the leap
+   midnight. It has to follow true POSIX time all along. @return how many
+   of the readings showed 23:59:59
+*/
+static int readThroughLeap(uint8_t announced) {
+  startBefore(3600 * SECOND);
+  sync();
+  TEST_ASSERT_EQUAL(announced, client->getLeapIndicator());
+  TEST_ASSERT_EQUAL_UINT64(LEAP, client->getLeapTime());
+
+  sim::advance((uint64_t)(-3 * (int64_t)SECOND + 125000 - sinceMidnight()));
+  int lastSecond = 0;
+  uint64_t last = 0;
+  for (int i = 0; i < 24; i++) {
+    uint64_t shown = client->getUtcMicros();
+    TEST_ASSERT_INT64_WITHIN(1000, (int64_t)sim::utcMicros(), (int64_t)shown);
+    TEST_ASSERT_TRUE(shown >= last || shown / SECOND == LEAP - 1); // Back only to repeat 23:59:59
+    if (shown / SECOND == LEAP - 1) lastSecond++;
+    last = shown;
+    sim::advance(250000);
+  }
+  TEST_ASSERT_EQUAL(NTP_LEAP_NONE, client->getLeapIndicator());
+  return lastSecond;
+}
+
+/**
+   An inserted second: 23:59:59 is shown for two seconds.
+*/
+void test_inserted_second_repeats_2359_59() {
+  sim::setLeapSecond(LEAP, 1);
+  TEST_ASSERT_EQUAL(8, readThroughLeap(NTP_LEAP_INSERT));
+}
+
+/**
+   A deleted second: 23:59:58 is followed by 00:00:00.
+*/
+void test_deleted_second_skips_2359_59() {
+  sim::setLeapSecond(LEAP, -1);
+  TEST_ASSERT_EQUAL(0, readThroughLeap(NTP_LEAP_DELETE));
+}
+
+/**
+   With a one-hour smear the clock leaves true time from 23:30 on, by a
+   second an hour: half a second behind at midnight for an inserted
+   second (half ahead for a deleted one) and back on it at 00:30, never
+   repeating or skipping a second on the way.
+*/
+static void smearThroughLeap(int direction) {
+  sim::setLeapSecond(LEAP, direction);
+  client->setLeapSmear(3600);
+  startBefore(3600 * SECOND);
+  sync();
+
+  uint64_t last = 0;
+  for (int64_t at = -2400; at <= 2400; at += 60) {
+    sim::advance((uint64_t)(at * (int64_t)SECOND - sinceMidnight()));
+    int64_t into = constrain(sinceMidnight() + 1800 * (int64_t)SECOND, (int64_t)0, 3600 * (int64_t)SECOND);
+    int64_t smear = -direction * into / 3600; // Of the second, in µs
+    uint64_t uniform = LEAP * SECOND + sinceMidnight();
+    uint64_t shown = client->getUtcMicros();
+    TEST_ASSERT_INT64_WITHIN(1000, (int64_t)uniform + smear, (int64_t)shown);
+    TEST_ASSERT_TRUE(shown > last);
+    last = shown;
+  }
+  TEST_ASSERT_INT64_WITHIN(1000, (int64_t)sim::utcMicros(), (int64_t)client->getUtcMicros());
+}
+
+void test_smear_ramps_inserted_second() {
+  smearThroughLeap(1);
+}
+
+void test_smear_ramps_deleted_second() {
+  smearThroughLeap(-1);
+}
+
+int main() {
+  sim::setVirtualTime(true);
+  sim::setEpoch(LEAP);
+  sim::addRoute(nullptr, 123, server.begin());
+  UNITY_BEGIN();
+  RUN_TEST(test_inserted_second_repeats_2359_59);
+  RUN_TEST(test_deleted_second_skips_2359_59);
+  RUN_TEST(test_smear_ramps_inserted_second);
+  RUN_TEST(test_smear_ramps_deleted_second);
+  return UNITY_END();
+}
@@ -0,0 +1,213 @@
+/*
+  Host tests of the NTP header codec: random and mangled headers against a
+  byte-by-byte decoding, and the parse throughput. Run with
+  `pio test -e native`.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <NTPPacket.h>
+
+static const uint64_t T1 = 1760000000123456ULL; // Transmit time of "our" request
+
+static uint32_t seed = 12345;
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t nextRandom() {
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static uint32_t word(const byte* packet, uint8_t at) {
+  return (uint32_t)packet[at] << 24 | (uint32_t)packet[at + 1] << 16 | (uint32_t)packet[at + 2] << 8 | packet[at + 3];
+}
+
+/**
+   A timestamp in microseconds since 1970, spelled out: era 1 (from 2036)
+   when the top bit of the seconds is clear.
+*/
+static uint64_t timestamp(const byte* packet, uint8_t at) {
+  uint64_t seconds = word(packet, at);
+  if (!(seconds & 0x80000000)) seconds += 0x100000000ULL;
+  return (seconds - SEVENZYYEARS) * 1000000 + (((uint64_t)word(packet, at + 4) * 1000000) >> 32);
+}
+
+/**
+   What checkReply() should say, spelled out from the RFC 5905 layout.
+*/
+static NTPReplyStatus expectedStatus(const byte* packet) {
+  uint8_t leap = packet[0] >> 6, version = (packet[0] >> 3) & 7, mode = packet[0] & 7, stratum = packet[1];
+  if (mode != 4 || version < 1 || version > 4) return NTP_REPLY_BAD_MODE;
+  if (stratum == 0) return NTP_REPLY_KISS;
+  if (leap == 3 || stratum >= 16) return NTP_REPLY_UNSYNCHRONIZED;
+  if ((word(packet, 32) | word(packet, 36)) == 0 || (word(packet, 40) | word(packet, 44)) == 0) {
+    return NTP_REPLY_BAD_TIMESTAMPS;
+  }
+  return timestamp(packet, 40) < timestamp(packet, 32) ? NTP_REPLY_BAD_TIMESTAMPS : NTP_REPLY_OK;
+}
+
+/**
+   A well-formed reply to the request sent at T1.
+*/
+static void makeGoodReply(byte* buffer) {
+  NTPPacket packet(buffer);
+  packet.makeRequest(T1);
+  packet.makeReply(NTP_LEAP_NONE);
+  packet.setStratum(2);
+  packet.setRootDelayMicros(12000);
+  packet.setRootDispersionMicros(3000);
+  packet.setReferenceId(NTPPacket::code("GPS "));
+  packet.setReferenceMicros(T1 - 30000000);
+  packet.setReceiveMicros(T1 + 20000);
+  packet.setTransmitMicros(T1 + 20050);
+}
+
+/**
+   Random headers: every field decodes to what the bytes say, and
+   checkReply() agrees with the rules spelled out byte by byte.
+*/
+void test_random_headers_decode_like_the_bytes() {
+  byte buffer[NTP_PACKET_SIZE];
+  NTPPacket packet(buffer);
+  int accepted = 0;
+  for (int i = 0; i < 200000; i++) {
+    for (uint8_t j = 0; j < NTP_PACKET_SIZE; j += 4) {
+      uint32_t value = nextRandom();
+      memcpy(buffer + j, &value, 4);
+    }
+    // Bias the first bytes towards plausible replies, so every check is reached
+    if (i % 2) buffer[0] = (buffer[0] & 0xC0) | 4 << 3 | NTP_MODE_SERVER;
+    if (i % 4 == 1) buffer[1] &= 0x0F;
+    if (i % 8 == 1) memcpy(buffer + 40, buffer + 32, 4);
+
+    TEST_ASSERT_EQUAL(buffer[0] >> 6, packet.leap());
+    TEST_ASSERT_EQUAL((buffer[0] >> 3) & 7, packet.version());
+    TEST_ASSERT_EQUAL(buffer[0] & 7, packet.mode());
+    TEST_ASSERT_EQUAL(buffer[1], packet.stratum());
+    TEST_ASSERT_EQUAL((int8_t)buffer[2], packet.poll());
+    TEST_ASSERT_EQUAL((int8_t)buffer[3], packet.precision());
+    TEST_ASSERT_EQUAL_UINT32(word(buffer, 12), packet.referenceId());
+    TEST_ASSERT_EQUAL_UINT32(((uint64_t)word(buffer, 4) * 1000000) >> 16, packet.rootDelayMicros());
+    TEST_ASSERT_EQUAL_UINT32(((uint64_t)word(buffer, 8) * 1000000) >> 16, packet.rootDispersionMicros());
+
+    TEST_ASSERT_EQUAL_UINT64(timestamp(buffer, 16), packet.referenceMicros());
+    TEST_ASSERT_EQUAL_UINT64(timestamp(buffer, 24), packet.originateMicros());
+    TEST_ASSERT_EQUAL_UINT64(timestamp(buffer, 32), packet.receiveMicros());
+    TEST_ASSERT_EQUAL_UINT64(timestamp(buffer, 40), packet.transmitMicros());
+
+    NTPReplyStatus status = packet.checkReply();
+    TEST_ASSERT_EQUAL(expectedStatus(buffer), status);
+    if (status == NTP_REPLY_OK) accepted++;
+    TEST_ASSERT_FALSE(packet.isReplyTo(T1)); // Randomly the right 64 bits: not in this lifetime
+  }
+  TEST_ASSERT_GREATER_THAN(1000, accepted);
+}
+
+/**
+   A good reply with one to three random bits flipped: it only stays a
+   reply to T1 if the originate timestamp is untouched, and only passes
+   the checks if the header still says what a reply has to.
+*/
+void test_mangled_replies_are_caught() {
+  byte good[NTP_PACKET_SIZE];
+  makeGoodReply(good);
+  NTPPacket goodPacket(good);
+  TEST_ASSERT_EQUAL(NTP_REPLY_OK, goodPacket.checkReply());
+  TEST_ASSERT_TRUE(goodPacket.isReplyTo(T1));
+  TEST_ASSERT_FALSE(goodPacket.isReplyTo(T1 + 1));
+
+  byte buffer[NTP_PACKET_SIZE];
+  NTPPacket packet(buffer);
+  for (int i = 0; i < 100000; i++) {
+    memcpy(buffer, good, NTP_PACKET_SIZE);
+    bool originateTouched = false;
+    for (uint8_t flips = 1 + nextRandom() % 3; flips > 0; flips--) {
+      uint16_t bit = nextRandom() % (NTP_PACKET_SIZE * 8);
+      buffer[bit / 8] ^= 1 << (bit % 8);
+      originateTouched |= bit / 8 >= 24 && bit / 8 < 32;
+    }
+    originateTouched &= memcmp(buffer + 24, good + 24, 8) != 0; // Flipped twice is no change
+    TEST_ASSERT_EQUAL(!originateTouched, packet.isReplyTo(T1));
+    TEST_ASSERT_EQUAL(expectedStatus(buffer), packet.checkReply());
+  }
+}
+
+/**
+   A request turned into its reply keeps the request's version and echoes
+   its transmit timestamp; timestamps written read back to the
+   microsecond, down to 1970 and across 2036.
+*/
+void test_request_reply_round_trip() {
+  byte buffer[NTP_PACKET_SIZE];
+  NTPPacket packet(buffer);
+  packet.makeRequest(T1);
+  TEST_ASSERT_EQUAL(NTP_MODE_CLIENT, packet.mode());
+  TEST_ASSERT_EQUAL(4, packet.version());
+  TEST_ASSERT_EQUAL_UINT64(T1, packet.transmitMicros());
+
+  packet.makeReply(NTP_LEAP_INSERT);
+  TEST_ASSERT_EQUAL(NTP_MODE_SERVER, packet.mode());
+  TEST_ASSERT_EQUAL(NTP_LEAP_INSERT, packet.leap());
+  TEST_ASSERT_EQUAL(4, packet.version());
+  TEST_ASSERT_TRUE(packet.isReplyTo(T1));
+
+  for (int i = 0; i < 100000; i++) {
+    // Anywhere from 1968 to 2104, what the era rule covers
+    uint64_t seconds = 0x80000000ULL + nextRandom() % 0xFFFFFFFFULL - SEVENZYYEARS;
+    uint64_t time = seconds * 1000000 + nextRandom() % 1000000;
+    if (time >= (uint64_t)(0x100000000ULL + 0x80000000ULL - SEVENZYYEARS) * 1000000) continue;
+    packet.setReceiveMicros(time);
+    TEST_ASSERT_EQUAL_UINT64(time, packet.receiveMicros());
+  }
+
+  packet.setRootDispersionMicros(1500000);
+  TEST_ASSERT_UINT64_WITHIN(16, 1500000, packet.rootDispersionMicros());
+}
+
+/**
+   Parse throughput: every field and the checks, over a set of replies as
+   the client sees them. Reported, and bounded loosely enough for a busy
+   build machine; the target parses in place too, with no copy to speed
+   up.
+*/
+void test_parse_throughput() {
+  static const int PACKETS = 64;
+  static const int ROUNDS = 20000;
+  byte buffers[PACKETS][NTP_PACKET_SIZE];
+  for (int i = 0; i < PACKETS; i++) {
+    makeGoodReply(buffers[i]);
+    buffers[i][47] ^= i; // A different transmit fraction each
+  }
+
+  volatile uint64_t sink = 0;
+  unsigned long start = micros();
+  for (int round = 0; round < ROUNDS; round++) {
+    for (int i = 0; i < PACKETS; i++) {
+      NTPPacket packet(buffers[i]);
+      uint64_t sum = packet.checkReply() + packet.isReplyTo(T1) + packet.stratum() + packet.rootDelayMicros() +
+                     packet.rootDispersionMicros() + packet.referenceId() + packet.originateMicros() +
+                     packet.receiveMicros() + packet.transmitMicros();
+      sink = sink + sum;
+    }
+  }
+  unsigned long elapsed = micros() - start;
+
+  char line[80];
+  snprintf(line, sizeof(line), "%d replies parsed in %lu us, %lu ns each", PACKETS * ROUNDS, elapsed,
+           (unsigned long)((uint64_t)elapsed * 1000 / (PACKETS * ROUNDS)));
+  TEST_MESSAGE(line);
+  TEST_ASSERT_LESS_THAN(PACKETS * ROUNDS, elapsed); // Under 1 us each
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_random_headers_decode_like_the_bytes);
+  RUN_TEST(test_mangled_replies_are_caught);
+  RUN_TEST(test_request_reply_round_trip);
+  RUN_TEST(test_parse_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,98 @@
+/*
+  Host tests of NTPClient against the fake server in real time: the clock
+  moves on between any two reads of it, which virtual time hides.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <FakeNtpServer.h>
+#include <HostSim.h>
+#include <NTPClient.h>
+#include <WiFiUdp.h>
+
+static FakeNtpServer server;
+static WiFiUDP udp;
+
+void setUp() {}
+void tearDown() {}
+
+static void runUpdate(NTPClient& client) {
+  uint64_t start = sim::elapsedMicros();
+  while (client.isUpdating() && sim::elapsedMicros() - start < 10000000) {
+    client.poll();
+    sim::advance(1000);
+  }
+}
+
+/**
+   Each reply sends the next request of the burst, stamped after the reply
+   was read; that request must not count as timed out at once.
+*/
+void test_burst_collects_every_sample() {
+  server.setDelayMicros(2000, 2000);
+  NTPClient client(udp);
+  client.setBurstSize(4);
+  client.begin();
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_TRUE(client.beginUpdate());
+    runUpdate(client);
+    TEST_ASSERT_TRUE(client.isTimeSet());
+    TEST_ASSERT_EQUAL(4, client.getSampleCount());
+  }
+  TEST_ASSERT_EQUAL(0, client.getRejectedCount());
+  TEST_ASSERT_EQUAL(20, server.requests());
+  client.end();
+}
+
+static uint64_t arrivalTime() {
+  return udp.arrivalMicros();
+}
+
+/**
+   Mean error of the clock right after a first sync, over a number of
+   fresh clients syncing with bursts of that size. The first sync steps
+   the clock to its best sample, so this is that sample's error.
+*/
+static int64_t meanSyncError(uint8_t burstSize) {
+  int64_t sum = 0;
+  for (int i = 0; i < 10; i++) {
+    NTPClient client(udp);
+    client.setBurstSize(burstSize);
+    client.setArrivalTime(arrivalTime);
+    client.begin();
+    TEST_ASSERT_TRUE(client.beginUpdate());
+    runUpdate(client);
+    TEST_ASSERT_TRUE(client.isTimeSet());
+    TEST_ASSERT_EQUAL(burstSize, client.getSampleCount());
+    int64_t error = (int64_t)client.getUtcMicros() - (int64_t)sim::utcMicros();
+    sum += error < 0 ? -error : error;
+    client.end();
+  }
+  return sum / 10;
+}
+
+/**
+   Replies held back by up to 20 ms at random: one sample is off by half
+   its extra delay, 5 ms on average. The quickest of a burst of eight has
+   little extra delay left.
+*/
+void test_burst_reduces_jitter_error() {
+  server.setDelayMicros(2000, 2000);
+  server.setJitterMicros(20000);
+  int64_t single = meanSyncError(1);
+  int64_t burst = meanSyncError(8);
+  server.setJitterMicros(0);
+
+  TEST_ASSERT_GREATER_THAN(2500, single);
+  TEST_ASSERT_LESS_THAN(2000, burst);
+  TEST_ASSERT_LESS_THAN(single / 2, burst);
+}
+
+int main() {
+  sim::addRoute(nullptr, 123, server.begin());
+
+  UNITY_BEGIN();
+  RUN_TEST(test_burst_collects_every_sample);
+  RUN_TEST(test_burst_reduces_jitter_error);
+  return UNITY_END();
+}
@@ -0,0 +1,188 @@
+/*
+  Host tests of the NTP server address cache against the shim's stub DNS:
+  answers kept for their TTL, a pool's answers building up and rotating
+  when one stops answering, and lookups retried after a failure.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <FakeNtpServer.h>
+#include <HostSim.h>
+#include <NTPClient.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+static const uint64_t SECOND = 1000000;
+
+static FakeNtpServer server;
+static WiFiUDP udp;
+static NTPClient* client;
+
+// What the resolver does: look the name up in the stub DNS, fail, or only
+// start the lookup and leave the answer to addServerAddresses()
+enum DnsMode { DNS_ANSWER, DNS_FAIL, DNS_PENDING };
+static DnsMode dnsMode;
+static unsigned long dnsTtl;
+static int resolverCalls;
+
+static uint8_t lookUp(const char* host, IPAddress* addresses, uint8_t, unsigned long& ttl) {
+  resolverCalls++;
+  if (dnsMode != DNS_ANSWER || WiFi.hostByName(host, addresses[0]) != 1) return 0;
+  ttl = dnsTtl;
+  return 1;
+}
+
+/**
+   @return the stub DNS member an address stands for
+*/
+static int member(const IPAddress& address) {
+  return (address[3] - 1) % 8;
+}
+
+/**
+   One update to the end. @return whether the pool server answered
+*/
+static bool sync() {
+  TEST_ASSERT_TRUE(client->beginUpdate());
+  while (client->isUpdating()) {
+    client->poll();
+    sim::advance(1000);
+  }
+  return client->getServer(0).reach & 1;
+}
+
+void setUp() {
+  dnsMode = DNS_ANSWER;
+  dnsTtl = 300;
+  resolverCalls = 0;
+  sim::setDnsAddresses(1);
+  sim::setDnsDeadAddress(-1);
+  client = new NTPClient(udp);
+  client->setResolver(lookUp);
+  client->begin();
+}
+
+void tearDown() {
+  client->end();
+  delete client;
+}
+
+/**
+   An answer is not looked up again until its TTL is over, and the time to
+   the next lookup counts down to it.
+*/
+void test_answer_kept_for_its_ttl() {
+  uint64_t lookups = sim::dnsLookups();
+  TEST_ASSERT_UINT32_WITHIN(1, 300000, client->resolveServers());
+  TEST_ASSERT_EQUAL_UINT64(lookups + 1, sim::dnsLookups());
+  TEST_ASSERT_EQUAL(1, client->getServer(0).addressCount);
+
+  sim::advance(299 * SECOND);
+  TEST_ASSERT_TRUE(sync()); // From the cache, no lookup
+  TEST_ASSERT_UINT32_WITHIN(10, 1000, client->resolveServers());
+  TEST_ASSERT_EQUAL_UINT64(lookups + 1, sim::dnsLookups());
+
+  sim::advance(SECOND);
+  TEST_ASSERT_UINT32_WITHIN(1, 300000, client->resolveServers());
+  TEST_ASSERT_EQUAL_UINT64(lookups + 2, sim::dnsLookups());
+  TEST_ASSERT_EQUAL(1, client->getServer(0).addressCount); // The same address again
+}
+
+/**
+   A pool that answers with another member each time: the cache builds up
+   all three, keeps using the first, and moves on to the next when it stops
+   answering.
+*/
+void test_pool_answers_build_up_and_rotate() {
+  sim::setDnsAddresses(3);
+  dnsTtl = 60;
+  for (int i = 0; i < 3; i++) {
+    client->resolveServers();
+    sim::advance(60 * SECOND);
+  }
+  const NTPPeer& peer = client->getServer(0);
+  TEST_ASSERT_EQUAL(3, peer.addressCount);
+  TEST_ASSERT_TRUE(peer.addresses[0] != peer.addresses[1] && peer.addresses[1] != peer.addresses[2] &&
+                   peer.addresses[0] != peer.addresses[2]);
+  TEST_ASSERT_TRUE(peer.addresses[peer.address] == peer.addresses[2]); // The first answer, still in use
+  TEST_ASSERT_TRUE(sync());
+
+  IPAddress dead = peer.addresses[peer.address];
+  sim::setDnsDeadAddress(member(dead));
+  TEST_ASSERT_FALSE(sync());
+  TEST_ASSERT_TRUE(peer.addresses[peer.address] != dead);
+  TEST_ASSERT_TRUE(sync());
+  TEST_ASSERT_EQUAL(3, peer.addressCount);
+}
+
+/**
+   A single address that stops answering leaves nothing to move on to: the
+   name is looked up again before the next update, whatever its TTL.
+*/
+void test_silent_only_address_looked_up_again() {
+  TEST_ASSERT_TRUE(sync());
+  int calls = resolverCalls;
+  sim::setDnsDeadAddress(member(client->getServer(0).addresses[0]));
+  TEST_ASSERT_FALSE(sync());
+  TEST_ASSERT_UINT32_WITHIN(1, 300000, client->resolveServers()); // Due at once, then good for its TTL again
+  TEST_ASSERT_EQUAL(calls + 1, resolverCalls);
+}
+
+/**
+   A failed lookup keeps the old addresses, which still work, and is tried
+   again after NTP_DNS_RETRY seconds rather than after the TTL.
+*/
+void test_failed_lookup_retried() {
+  client->resolveServers();
+  IPAddress address = client->getServer(0).addresses[0];
+  sim::advance(300 * SECOND);
+
+  dnsMode = DNS_FAIL;
+  TEST_ASSERT_UINT32_WITHIN(1, NTP_DNS_RETRY * 1000UL, client->resolveServers());
+  TEST_ASSERT_EQUAL(2, resolverCalls);
+  TEST_ASSERT_EQUAL(1, client->getServer(0).addressCount);
+  TEST_ASSERT_TRUE(client->getServer(0).addresses[0] == address);
+  TEST_ASSERT_TRUE(sync());
+
+  sim::advance((NTP_DNS_RETRY - 1) * SECOND);
+  client->resolveServers();
+  TEST_ASSERT_EQUAL(2, resolverCalls);
+
+  dnsMode = DNS_ANSWER;
+  sim::advance(SECOND);
+  TEST_ASSERT_UINT32_WITHIN(1, 300000, client->resolveServers());
+  TEST_ASSERT_EQUAL(3, resolverCalls);
+}
+
+/**
+   A resolver that only starts the lookup: nothing to ask until the answer
+   is handed in, then it is cached for the TTL it came with.
+*/
+void test_answer_handed_in_later() {
+  dnsMode = DNS_PENDING;
+  client->resolveServers();
+  TEST_ASSERT_EQUAL(0, client->getServer(0).addressCount);
+  TEST_ASSERT_FALSE(client->beginUpdate());
+
+  IPAddress address;
+  TEST_ASSERT_TRUE(WiFi.hostByName("pool.ntp.org", address));
+  TEST_ASSERT_FALSE(client->addServerAddresses(1, &address, 1, 120)); // No such server
+  TEST_ASSERT_TRUE(client->addServerAddresses(0, &address, 1, 120));
+  TEST_ASSERT_EQUAL(1, client->getServer(0).addressCount);
+  TEST_ASSERT_UINT32_WITHIN(1, 120000, client->resolveServers());
+  TEST_ASSERT_EQUAL(1, resolverCalls);
+  TEST_ASSERT_TRUE(sync());
+}
+
+int main() {
+  sim::setVirtualTime(true);
+  sim::setEpoch(1760000000);
+  sim::addRoute("pool.ntp.org", 123, server.begin());
+  UNITY_BEGIN();
+  RUN_TEST(test_answer_kept_for_its_ttl);
+  RUN_TEST(test_pool_answers_build_up_and_rotate);
+  RUN_TEST(test_silent_only_address_looked_up_again);
+  RUN_TEST(test_failed_lookup_retried);
+  RUN_TEST(test_answer_handed_in_later);
+  return UNITY_END();
+}
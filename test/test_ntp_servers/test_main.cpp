@@ -0,0 +1,125 @@
+/*
+  Host tests of asking several NTP servers at once, each its own fake
+  responder in virtual time: three that agree outvote one that is 200 ms
+  off, and the time follows the rest when one of them goes quiet.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <FakeNtpServer.h>
+#include <HostSim.h>
+#include <NTPClient.h>
+#include <WiFiUdp.h>
+
+static const char* NAMES[] = {"a.ntp.test", "b.ntp.test", "c.ntp.test", "d.ntp.test"};
+static const int64_t OFFSETS[] = {0, 500, -500, 200000}; // In us; d is the falseticker
+
+static FakeNtpServer servers[4];
+static WiFiUDP udp;
+static NTPClient client(udp);
+
+void setUp() {}
+void tearDown() {}
+
+static bool updated;
+
+static void onUpdate(bool success) {
+  updated = success;
+}
+
+/**
+   One update to the end. @return whether it set the clock
+*/
+static bool sync() {
+  updated = false;
+  TEST_ASSERT_TRUE(client.beginUpdate());
+  while (client.isUpdating()) {
+    for (int i = 0; i < 4; i++) client.poll(); // Replies that arrived together, one per poll()
+    sim::advance(1000);
+  }
+  return updated;
+}
+
+static int64_t clockError() {
+  return (int64_t)client.getUtcMicros() - (int64_t)sim::utcMicros();
+}
+
+/**
+   All four answer; d's interval misses the other three and it is left out
+   of the time, which lands among theirs.
+*/
+void test_falseticker_outvoted() {
+  TEST_ASSERT_EQUAL(4, client.getServerCount());
+  for (int i = 0; i < 2; i++) {
+    TEST_ASSERT_TRUE(sync());
+    TEST_ASSERT_INT64_WITHIN(600, 0, clockError());
+    sim::advance(64000000);
+  }
+  for (uint8_t i = 0; i < 4; i++) {
+    const NTPPeer& peer = client.getServer(i);
+    TEST_ASSERT_EQUAL_STRING(NAMES[i], peer.name);
+    TEST_ASSERT_EQUAL(0x03, peer.reach);
+    TEST_ASSERT_EQUAL(i < 3, peer.selected);
+  }
+  TEST_ASSERT_INT64_WITHIN(1000, OFFSETS[3], client.getServer(3).offset);
+}
+
+/**
+   a stops answering: its reach shows the miss, b and c still outvote d and
+   the clock stays with them.
+*/
+void test_fails_over_when_a_server_goes_quiet() {
+  servers[0].setLossPercent(100);
+  TEST_ASSERT_TRUE(sync());
+  TEST_ASSERT_EQUAL(0x06, client.getServer(0).reach);
+  TEST_ASSERT_FALSE(client.getServer(0).selected);
+  TEST_ASSERT_TRUE(client.getServer(1).selected);
+  TEST_ASSERT_TRUE(client.getServer(2).selected);
+  TEST_ASSERT_FALSE(client.getServer(3).selected);
+  TEST_ASSERT_INT64_WITHIN(600, 0, clockError());
+  TEST_ASSERT_TRUE(client.getReferenceIP() != IPAddress());
+}
+
+/**
+   b goes quiet too: c and d disagree with nobody to break the tie, so the
+   update fails and the clock is left alone rather than pulled towards d.
+   Once a answers again it is back in the majority.
+*/
+void test_no_majority_leaves_the_clock_alone() {
+  sim::advance(64000000);
+  servers[1].setLossPercent(100);
+  TEST_ASSERT_FALSE(sync());
+  TEST_ASSERT_FALSE(client.getServer(2).selected);
+  TEST_ASSERT_FALSE(client.getServer(3).selected);
+  TEST_ASSERT_EQUAL(0x0F, client.getServer(3).reach);
+  TEST_ASSERT_EQUAL(0x0E, client.getServer(1).reach);
+  TEST_ASSERT_INT64_WITHIN(600, 0, clockError());
+
+  servers[0].setLossPercent(0);
+  sim::advance(64000000);
+  TEST_ASSERT_TRUE(sync());
+  TEST_ASSERT_TRUE(client.getServer(0).selected);
+  TEST_ASSERT_TRUE(client.getServer(2).selected);
+  TEST_ASSERT_FALSE(client.getServer(3).selected);
+  TEST_ASSERT_INT64_WITHIN(600, 0, clockError());
+}
+
+int main() {
+  sim::setVirtualTime(true);
+  sim::setEpoch(1760000000);
+  for (int i = 0; i < 4; i++) {
+    servers[i].setOffsetMicros(OFFSETS[i]);
+    servers[i].setDelayMicros(1000, 1000);
+    servers[i].setSeed(i + 1);
+    sim::addRoute(NAMES[i], 123, servers[i].begin());
+  }
+  client.setPoolServerName(NAMES[0]);
+  for (int i = 1; i < 4; i++) client.addServer(NAMES[i]);
+  client.setUpdateCallback(onUpdate);
+  client.begin();
+  UNITY_BEGIN();
+  RUN_TEST(test_falseticker_outvoted);
+  RUN_TEST(test_fails_over_when_a_server_goes_quiet);
+  RUN_TEST(test_no_majority_leaves_the_clock_alone);
+  return UNITY_END();
+}
@@ -0,0 +1,153 @@
+/*
+  Host tests of the non-blocking NTP transaction: beginUpdate() and poll()
+  against the shim's fake server in virtual time, with latency, loss and
+  no answer at all.
+*/
+#include <Arduino.h>
+#include <unity.h>
+
+#include <FakeNtpServer.h>
+#include <HostSim.h>
+#include <NTPClient.h>
+#include <WiFiUdp.h>
+
+static FakeNtpServer server;
+static WiFiUDP udp;
+static NTPClient* client;
+
+static int callbacks;
+static bool lastSuccess;
+
+static void onUpdate(bool success) {
+  callbacks++;
+  lastSuccess = success;
+}
+
+/**
+   poll() every millisecond until the transaction is over, the way the
+   sketch does. @return simulated µs it took
+*/
+static uint64_t runUpdate() {
+  uint64_t start = sim::elapsedMicros();
+  while (client->isUpdating() && sim::elapsedMicros() - start < 60000000) {
+    client->poll();
+    sim::advance(1000);
+  }
+  return sim::elapsedMicros() - start;
+}
+
+void setUp() {
+  server.setDelayMicros(10000, 10000);
+  server.setLossPercent(0);
+  callbacks = 0;
+  lastSuccess = false;
+  client = new NTPClient(udp);
+  client->setUpdateCallback(onUpdate);
+  client->begin();
+}
+
+void tearDown() {
+  client->end();
+  delete client;
+}
+
+void test_reply_completes_update() {
+  TEST_ASSERT_TRUE(client->beginUpdate());
+  TEST_ASSERT_TRUE(client->isUpdating());
+  uint64_t took = runUpdate();
+
+  TEST_ASSERT_EQUAL(1, callbacks);
+  TEST_ASSERT_TRUE(lastSuccess);
+  TEST_ASSERT_TRUE(client->isTimeSet());
+  TEST_ASSERT_UINT64_WITHIN(2000, 21000, took);
+  TEST_ASSERT_INT_WITHIN(1000, 20000, client->getDelayMicros());
+  TEST_ASSERT_INT64_WITHIN(1000, (int64_t)sim::utcMicros(), (int64_t)client->getUtcMicros());
+}
+
+void test_lost_request_times_out() {
+  server.setLossPercent(100);
+  client->setUpdateTimeout(500);
+  TEST_ASSERT_TRUE(client->beginUpdate());
+  uint64_t took = runUpdate();
+
+  TEST_ASSERT_EQUAL(1, callbacks);
+  TEST_ASSERT_FALSE(lastSuccess);
+  TEST_ASSERT_FALSE(client->isTimeSet());
+  TEST_ASSERT_UINT64_WITHIN(2000, 501000, took);
+}
+
+/**
+   A reply slower than the timeout counts as lost, and when it turns up
+   later it is rejected rather than taken for the next request's.
+*/
+void test_late_reply_is_rejected() {
+  server.setDelayMicros(400000, 400000);
+  client->setUpdateTimeout(500);
+  TEST_ASSERT_TRUE(client->beginUpdate());
+  runUpdate();
+  TEST_ASSERT_EQUAL(1, callbacks);
+  TEST_ASSERT_FALSE(lastSuccess);
+
+  // The old reply comes in at 800 ms, while the new request still waits for its own
+  server.setDelayMicros(200000, 200000);
+  TEST_ASSERT_TRUE(client->beginUpdate());
+  runUpdate();
+  TEST_ASSERT_EQUAL(2, callbacks);
+  TEST_ASSERT_TRUE(lastSuccess);
+  TEST_ASSERT_EQUAL(1, client->getRejectedCount());
+  TEST_ASSERT_INT_WITHIN(1000, 400000, client->getDelayMicros());
+}
+
+/**
+   With requests dropped at random every transaction still ends in exactly
+   one callback: success as long as one reply of the burst came back.
+*/
+void test_every_update_reports_once_under_loss() {
+  server.setLossPercent(40);
+  client->setBurstSize(4);
+  int successes = 0;
+  for (int i = 0; i < 50; i++) {
+    int before = callbacks;
+    TEST_ASSERT_TRUE(client->beginUpdate());
+    runUpdate();
+    TEST_ASSERT_EQUAL(before + 1, callbacks);
+    if (lastSuccess) {
+      successes++;
+      TEST_ASSERT_TRUE(client->getSampleCount() >= 1 && client->getSampleCount() <= 4);
+    }
+    sim::advance(1000000);
+  }
+  TEST_ASSERT_GREATER_THAN(0, successes);
+  TEST_ASSERT_LESS_THAN(50, successes);
+}
+
+/**
+   Starting over abandons the outstanding request: its reply no longer
+   matches and only the new transaction reports.
+*/
+void test_restart_abandons_outstanding_request() {
+  TEST_ASSERT_TRUE(client->beginUpdate());
+  sim::advance(5000);
+  client->poll();
+  TEST_ASSERT_TRUE(client->beginUpdate());
+  runUpdate();
+
+  TEST_ASSERT_EQUAL(1, callbacks);
+  TEST_ASSERT_TRUE(lastSuccess);
+  TEST_ASSERT_EQUAL(1, client->getRejectedCount());
+  TEST_ASSERT_INT_WITHIN(1000, 20000, client->getDelayMicros());
+}
+
+int main() {
+  sim::setVirtualTime(true);
+  sim::setEpoch(1760000000);
+  sim::addRoute(nullptr, 123, server.begin());
+
+  UNITY_BEGIN();
+  RUN_TEST(test_reply_completes_update);
+  RUN_TEST(test_lost_request_times_out);
+  RUN_TEST(test_late_reply_is_rejected);
+  RUN_TEST(test_every_update_reports_once_under_loss);
+  RUN_TEST(test_restart_abandons_outstanding_request);
+  return UNITY_END();
+}